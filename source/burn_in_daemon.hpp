@@ -0,0 +1,279 @@
+#pragma once
+
+#include "instruction_test.hpp"
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+// Burn-in: cycle through the kernels forever on every thread,
+// and export rolling-window metrics to a node-exporter textfile
+class BurnInDaemon
+{
+public:
+    typedef std::function<std::shared_ptr<InstructionTest>(int mode, int type)> Factory;
+
+    struct Kernel
+    {
+        int mode;
+        int type;
+    };
+
+    std::vector<Kernel> kernels;
+    int threads = 0; // 0 for all the allowed processors, at most one thread per processor
+    int operand = 1;
+    int denormal_ratio = 50;
+    bool ftz_daz = false;
+    double period = 60; // seconds of each kernel before switching to the next one
+    double window = 60; // seconds of the rolling window
+    double interval = 15; // seconds between the textfile updates
+    double duration = 0; // seconds to run, 0 until SIGINT/SIGTERM
+    std::string textfile = "mybench.prom";
+
+    explicit BurnInDaemon(const Factory &factory)
+        : factory(factory)
+    {
+    }
+
+    // run until the duration has elapsed or a signal arrives, return 1 if any error was found
+    int Run()
+    {
+        const std::vector<int> cpus = AllowedCPUs();
+        const int procs = static_cast<int>(cpus.size());
+        const int count = threads > 0 ? std::min(threads, procs) : procs;
+
+        workers.clear();
+        for (int i = 0; i < count; ++i)
+        {
+            workers.emplace_back(new Worker);
+            workers.back()->index = i;
+            workers.back()->target = cpus[i];
+            workers.back()->stats.resize(kernels.size());
+        }
+
+        Stopped() = false;
+        std::signal(SIGINT, OnSignal);
+        std::signal(SIGTERM, OnSignal);
+        start = MyClock::now();
+
+        std::cout << "Burn-in of " << kernels.size() << " kernels on " << count << " threads, "
+            << period << " seconds each, writing \"" << textfile << "\" every " << interval << " seconds.\n";
+
+        std::thread writer([this]() { writeLoop(); });
+
+#pragma omp parallel num_threads(count)
+        {
+#ifdef _OPENMP
+            work(*workers[omp_get_thread_num()]);
+#else
+            work(*workers[0]);
+#endif
+        }
+
+        Stopped() = true;
+        writer.join();
+        writeTextfile();
+
+        uint64_t iterations = 0;
+        uint64_t errors = 0;
+        int unpinned = 0;
+        for (const std::unique_ptr<Worker> &w : workers)
+        {
+            if (w->cpu < 0) ++unpinned;
+            for (const Stats &s : w->stats)
+            {
+                iterations += s.iterations;
+                errors += s.errors;
+            }
+        }
+
+        if (unpinned > 0) std::cout << unpinned << " threads could not be pinned, their metrics are labelled cpu=\"none\".\n";
+        std::cout << "Stopped after " << elapsed() << " seconds: " << iterations << " loops, " << errors << " errors.\n";
+        return errors > 0 ? 1 : 0;
+    }
+
+private:
+    // loops of a kernel on a thread
+    struct Stats
+    {
+        std::deque<std::pair<double, double>> window; // end time and elapsed seconds of the recent loops
+        uint64_t iterations = 0;
+        uint64_t errors = 0;
+        bool verified = false; // whether the errors are counted, see InstructionTest::Verifiable()
+        double flops = 0; // of each loop
+        double bytes = 0;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex; // taken once per loop, and by the writer
+        int index = 0;
+        int target = 0; // CPU to pin the thread to
+        int cpu = -1; // CPU the thread is pinned to, -1 if the pinning failed
+        std::vector<Stats> stats; // for each kernel
+    };
+
+    Factory factory;
+    std::vector<std::unique_ptr<Worker>> workers;
+    MyClock::time_point start;
+
+    static std::atomic<bool> &Stopped()
+    {
+        static std::atomic<bool> stopped(false);
+        return stopped;
+    }
+
+    static void OnSignal(int)
+    {
+        Stopped() = true;
+    }
+
+    double elapsed() const
+    {
+        return std::chrono::duration_cast<MySeconds>(MyClock::now() - start).count();
+    }
+
+    bool finished() const
+    {
+        return Stopped() || (duration > 0 && elapsed() >= duration);
+    }
+
+    // a private single-threaded instance of each kernel in turn, switching every period
+    void work(Worker &worker)
+    {
+        const bool pinned = SetThreadAffinity(worker.target);
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.cpu = pinned ? worker.target : -1;
+        }
+        const unsigned int csr = SetFlushDenormals(ftz_daz);
+
+        std::shared_ptr<InstructionTest> test;
+        size_t current = kernels.size();
+
+        while (!finished())
+        {
+            const size_t k = static_cast<size_t>(elapsed() / period) % kernels.size();
+
+            if (k != current)
+            {
+                if (test) test->ReleaseTest();
+
+                test = factory(kernels[k].mode, kernels[k].type);
+                test->silent = true;
+                test->type = kernels[k].type;
+                test->operand = operand;
+                test->denormal_ratio = denormal_ratio;
+                test->ftz_daz = ftz_daz;
+                // the same memory footprint as the buffers shared by all the threads in RunTest()
+                test->length = std::max<size_t>(0x10000, test->length / workers.size());
+                test->InitTest();
+                current = k;
+
+                std::lock_guard<std::mutex> lock(worker.mutex);
+                worker.stats[k].flops = test->LoopFlops();
+                worker.stats[k].bytes = test->LoopBytes();
+                worker.stats[k].verified = test->Verifiable();
+            }
+
+            MyClock::time_point t1 = MyClock::now();
+            test->RunOnce();
+            MyClock::time_point t2 = MyClock::now();
+            const size_t errors = test->Verify();
+
+            const double end = std::chrono::duration_cast<MySeconds>(t2 - start).count();
+            const double seconds = std::chrono::duration_cast<MySeconds>(t2 - t1).count();
+
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            Stats &stats = worker.stats[k];
+            stats.window.emplace_back(end, seconds);
+            ++stats.iterations;
+            stats.errors += errors > 0 ? 1 : 0;
+            while (stats.window.front().first < end - window) stats.window.pop_front();
+        }
+
+        if (test) test->ReleaseTest();
+        _mm_setcsr(csr);
+        SetThreadAffinity(-1);
+    }
+
+    void writeLoop()
+    {
+        double next = interval;
+        while (!finished())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (elapsed() < next) continue;
+            writeTextfile();
+            next += interval;
+        }
+    }
+
+    // write a temporary file, then rename it over the textfile, so that readers never see a partial file
+    bool writeTextfile()
+    {
+        std::ostringstream gflops, bandwidth, loop_seconds, iterations, errors;
+        const double now = elapsed();
+
+        for (const std::unique_ptr<Worker> &w : workers)
+        {
+            std::lock_guard<std::mutex> lock(w->mutex);
+
+            for (size_t k = 0; k < kernels.size(); ++k)
+            {
+                Stats &s = w->stats[k];
+                const std::string labels = "{mode=\"" + std::to_string(kernels[k].mode)
+                    + "\",type=\"" + std::to_string(kernels[k].type)
+                    + "\",worker=\"" + std::to_string(w->index)
+                    + "\",cpu=\"" + (w->cpu >= 0 ? std::to_string(w->cpu) : "none") + "\"} ";
+
+                // the kernels that are not running age out of the window, and their gauges disappear
+                while (!s.window.empty() && s.window.front().first < now - window) s.window.pop_front();
+
+                iterations << "mybench_iterations_total" << labels << s.iterations << "\n";
+                if (s.verified) errors << "mybench_errors_total" << labels << s.errors << "\n";
+
+                if (s.window.empty()) continue;
+
+                double busy = 0;
+                for (const std::pair<double, double> &loop : s.window) busy += loop.second;
+                const double loops = static_cast<double>(s.window.size());
+
+                loop_seconds << "mybench_loop_seconds" << labels << busy / loops << "\n";
+                if (s.flops > 0) gflops << "mybench_gflops" << labels << s.flops * loops / (busy * 1e9) << "\n";
+                if (s.bytes > 0) bandwidth << "mybench_bandwidth_bytes_per_second" << labels << s.bytes * loops / busy << "\n";
+            }
+        }
+
+        const std::string temp = textfile + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::trunc);
+            file << "# HELP mybench_gflops Single precision GFLOPS of each thread over the rolling window.\n"
+                << "# TYPE mybench_gflops gauge\n" << gflops.str()
+                << "# HELP mybench_bandwidth_bytes_per_second Memory bandwidth of each thread over the rolling window.\n"
+                << "# TYPE mybench_bandwidth_bytes_per_second gauge\n" << bandwidth.str()
+                << "# HELP mybench_loop_seconds Average time of a loop of each thread over the rolling window.\n"
+                << "# TYPE mybench_loop_seconds gauge\n" << loop_seconds.str()
+                << "# HELP mybench_iterations_total Loops completed by each thread.\n"
+                << "# TYPE mybench_iterations_total counter\n" << iterations.str()
+                << "# HELP mybench_errors_total Loops whose outputs differ from the first loop of the kernel, only for type 1-3 (type 4-5 are not verified).\n"
+                << "# TYPE mybench_errors_total counter\n" << errors.str()
+                << "# HELP mybench_last_update_timestamp_seconds Time of the last update.\n"
+                << "# TYPE mybench_last_update_timestamp_seconds gauge\n"
+                << "mybench_last_update_timestamp_seconds " << std::time(nullptr) << "\n";
+            if (!file) return false;
+        }
+
+#ifdef _WIN32
+        return MoveFileExA(temp.c_str(), textfile.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        return std::rename(temp.c_str(), textfile.c_str()) == 0;
+#endif
+    }
+};
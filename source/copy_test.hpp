@@ -0,0 +1,569 @@
+#pragma once
+
+#include "instruction_test.hpp"
+#include <cstring>
+
+// Bandwidth of memcpy/memset engines over sizes and alignments (single thread)
+class CopyTest
+    : public InstructionTest
+{
+public:
+    size_t min_size = 16;
+    size_t max_size = size_t(1) << 30;
+    double min_time = 0.01; // seconds of each measurement
+    double crossover_margin = 1.05; // speedup needed to report another engine as the fastest
+
+    // source offset, destination offset, and distance of destination from source modulo 4 KiB
+    struct Alignment
+    {
+        const char *name;
+        size_t src_offset;
+        size_t dst_offset;
+        size_t page_phase;
+    };
+
+    std::vector<Alignment> copy_alignments = {
+        { "aligned", 0, 0, 2048 },
+        { "src+1", 1, 0, 2048 },
+        { "dst+1", 0, 1, 2048 },
+        { "src+32", 32, 0, 2048 },
+        { "4K aliased (dst-src = 64 mod 4 KiB)", 0, 0, 64 }
+    };
+
+    std::vector<Alignment> fill_alignments = {
+        { "aligned", 0, 0, 0 },
+        { "dst+1", 0, 1, 0 },
+        { "dst+32", 0, 32, 0 }
+    };
+
+    static std::string SizeName(size_t size)
+    {
+        if (size >= size_t(1) << 30 && size % (size_t(1) << 30) == 0) return std::to_string(size >> 30) + " GiB";
+        if (size >= size_t(1) << 20 && size % (size_t(1) << 20) == 0) return std::to_string(size >> 20) + " MiB";
+        if (size >= size_t(1) << 10 && size % (size_t(1) << 10) == 0) return std::to_string(size >> 10) + " KiB";
+        return std::to_string(size) + " B";
+    }
+
+    virtual void RunTest() override
+    {
+        beginTest();
+
+        // the source, a gap for the offsets, and the destination
+        const size_t region = (max_size + 64 + 4095) / 4096 * 4096 + 4096;
+        char *arena = nullptr;
+        AlignedMalloc(arena, region * 2, 4096);
+        std::memset(arena, 1, region * 2); // commit the pages
+
+        times = 0;
+        results.clear();
+
+        while (repeat <= 0 || times < repeat)
+        { // infinite loop for continuous tests
+            ++times;
+
+            for (const Alignment &align : copy_alignments)
+            {
+                char *src = arena + align.src_offset;
+                char *dst = arena + region + align.page_phase + align.dst_offset;
+                runTable(true, align, dst, src);
+            }
+
+            for (const Alignment &align : fill_alignments)
+            {
+                char *dst = arena + region + align.dst_offset;
+                runTable(false, align, dst, nullptr);
+            }
+        }
+
+        AlignedFree(arena);
+        endTest();
+    }
+
+protected:
+    virtual int engineCount() const { return 2; }
+
+    virtual const char *engineName(int engine) const
+    {
+        switch (engine)
+        {
+        case 0: return "libc";
+        case 1: return "rep movsb";
+        default: return "unknown";
+        }
+    }
+
+    virtual void copy(int engine, void *dst, const void *src, size_t size) const
+    {
+        switch (engine)
+        {
+        case 0:
+            std::memcpy(dst, src, size);
+            break;
+        case 1:
+            RepMovsb(dst, src, size);
+            break;
+        default:
+            break;
+        }
+    }
+
+    virtual void fill(int engine, void *dst, int value, size_t size) const
+    {
+        switch (engine)
+        {
+        case 0:
+            std::memset(dst, value, size);
+            break;
+        case 1:
+            RepStosb(dst, value, size);
+            break;
+        default:
+            break;
+        }
+    }
+
+    virtual void kernel() const override {}
+
+    // rep movsb/stosb, fast for large sizes with ERMS, and for short ones with FSRM
+    static void RepMovsb(void *dst, const void *src, size_t size)
+    {
+#ifdef _MSC_VER
+        __movsb(static_cast<unsigned char *>(dst), static_cast<const unsigned char *>(src), size);
+#else
+        asm volatile("rep movsb" : "+D"(dst), "+S"(src), "+c"(size) : : "memory");
+#endif
+    }
+
+    static void RepStosb(void *dst, int value, size_t size)
+    {
+#ifdef _MSC_VER
+        __stosb(static_cast<unsigned char *>(dst), static_cast<unsigned char>(value), size);
+#else
+        asm volatile("rep stosb" : "+D"(dst), "+c"(size) : "a"(value) : "memory");
+#endif
+    }
+
+    // GB/s of one engine, repeated until min_time is reached
+    double measure(bool is_copy, int engine, char *dst, const char *src, size_t size) const
+    {
+        for (size_t reps = 1; ; reps *= 2)
+        {
+            MyClock::time_point t1 = MyClock::now();
+            for (size_t r = 0; r < reps; ++r)
+            {
+                if (is_copy) copy(engine, dst, src, size);
+                else fill(engine, dst, static_cast<int>(r), size);
+            }
+            MySeconds time_span = std::chrono::duration_cast<MySeconds>(MyClock::now() - t1);
+
+            if (time_span.count() >= min_time)
+            {
+                return static_cast<double>(size) * reps / (time_span.count() * 1e9);
+            }
+        }
+    }
+
+    void runTable(bool is_copy, const Alignment &align, char *dst, const char *src) const
+    {
+        const int engines = engineCount();
+        std::vector<int> best_engines;
+        std::vector<size_t> best_sizes;
+
+        if (!silent)
+        {
+            std::cout << times << ": " << (is_copy ? "copy" : "fill") << ", " << align.name << ", GB/s (single thread)\n"
+                << "    size     ";
+            for (int e = 0; e < engines; ++e) std::cout << std::setw(16) << engineName(e);
+            std::cout << "\n";
+        }
+
+        for (size_t size = min_size; size <= max_size; size *= 2)
+        {
+            std::vector<double> rates(engines);
+
+            if (!silent) std::cout << "    " << std::left << std::setw(9) << SizeName(size) << std::right;
+
+            for (int e = 0; e < engines; ++e)
+            {
+                rates[e] = measure(is_copy, e, dst, src, size);
+                if (!silent) std::cout << std::setprecision(2) << std::setw(16) << rates[e];
+            }
+
+            if (!silent) std::cout << "\n";
+
+            // record the crossover points, where another engine is faster by more than the noise
+            int best = best_engines.empty() ? 0 : best_engines.back();
+            for (int e = 0; e < engines; ++e)
+            {
+                if (rates[e] > rates[best] * crossover_margin) best = e;
+            }
+
+            if (best_engines.empty() || best_engines.back() != best)
+            {
+                best_engines.push_back(best);
+                best_sizes.push_back(size);
+            }
+        }
+
+        if (!silent)
+        {
+            std::cout << "    Fastest:";
+            for (size_t i = 0; i < best_engines.size(); ++i)
+            {
+                const size_t last = i + 1 < best_sizes.size() ? best_sizes[i + 1] / 2 : max_size;
+                std::cout << (i ? "," : "") << " " << engineName(best_engines[i])
+                    << " for " << SizeName(best_sizes[i]) << " - " << SizeName(last);
+            }
+            std::cout << "\n\n";
+        }
+    }
+};
+
+
+class AVXCopyTest
+    : public CopyTest
+{
+public:
+    static const size_t simd_width = 32;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual int engineCount() const override { return 4; }
+
+    virtual const char *engineName(int engine) const override
+    {
+        switch (engine)
+        {
+        case 2: return "avx";
+        case 3: return "avx stream";
+        default: return CopyTest::engineName(engine);
+        }
+    }
+
+    virtual void copy(int engine, void *dst, const void *src, size_t size) const override
+    {
+        switch (engine)
+        {
+        case 2:
+            copyAVX(static_cast<char *>(dst), static_cast<const char *>(src), size);
+            break;
+        case 3:
+            streamAVX(static_cast<char *>(dst), static_cast<const char *>(src), size);
+            break;
+        default:
+            CopyTest::copy(engine, dst, src, size);
+            break;
+        }
+    }
+
+    virtual void fill(int engine, void *dst, int value, size_t size) const override
+    {
+        switch (engine)
+        {
+        case 2:
+            fillAVX(static_cast<char *>(dst), value, size);
+            break;
+        case 3:
+            streamFillAVX(static_cast<char *>(dst), value, size);
+            break;
+        default:
+            CopyTest::fill(engine, dst, value, size);
+            break;
+        }
+    }
+
+public:
+    // less than 32 bytes
+    static void copySmall(char *dst, const char *src, size_t size)
+    {
+        if (size >= 16)
+        { // two overlapping 16-byte moves
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + size - 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), a);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + size - 16), b);
+        }
+        else
+        {
+            for (size_t i = 0; i < size; ++i) dst[i] = src[i];
+        }
+    }
+
+    static void copyAVX(char *dst, const char *src, size_t size)
+    {
+        if (size < 32)
+        {
+            copySmall(dst, src, size);
+            return;
+        }
+
+        // the last 32 bytes are loaded first, as they may overlap the stores
+        const __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + size - 32));
+        size_t i = 0;
+
+        for (; i + 128 <= size; i += 128)
+        {
+            const __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 0x00));
+            const __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 0x20));
+            const __m256i a2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 0x40));
+            const __m256i a3 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 0x60));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 0x00), a0);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 0x20), a1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 0x40), a2);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 0x60), a3);
+        }
+        for (; i + 32 <= size; i += 32)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i)));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + size - 32), tail);
+    }
+
+    // non-temporal stores to the aligned part of the destination
+    static void streamAVX(char *dst, const char *src, size_t size)
+    {
+        if (size < 64)
+        {
+            copyAVX(dst, src, size);
+            return;
+        }
+
+        const __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+        const __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + size - 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), head);
+        size_t i = 32 - reinterpret_cast<uintptr_t>(dst) % 32;
+
+        for (; i + 128 <= size; i += 128)
+        {
+            const __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 0x00));
+            const __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 0x20));
+            const __m256i a2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 0x40));
+            const __m256i a3 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 0x60));
+            _mm256_stream_si256(reinterpret_cast<__m256i *>(dst + i + 0x00), a0);
+            _mm256_stream_si256(reinterpret_cast<__m256i *>(dst + i + 0x20), a1);
+            _mm256_stream_si256(reinterpret_cast<__m256i *>(dst + i + 0x40), a2);
+            _mm256_stream_si256(reinterpret_cast<__m256i *>(dst + i + 0x60), a3);
+        }
+        for (; i + 32 <= size; i += 32)
+        {
+            _mm256_stream_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i)));
+        }
+
+        _mm_sfence();
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + size - 32), tail);
+    }
+
+    static void fillAVX(char *dst, int value, size_t size)
+    {
+        if (size < 32)
+        {
+            std::memset(dst, value, size);
+            return;
+        }
+
+        const __m256i v = _mm256_set1_epi8(static_cast<char>(value));
+        size_t i = 0;
+
+        for (; i + 128 <= size; i += 128)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 0x00), v);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 0x20), v);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 0x40), v);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 0x60), v);
+        }
+        for (; i + 32 <= size; i += 32)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + size - 32), v);
+    }
+
+    static void streamFillAVX(char *dst, int value, size_t size)
+    {
+        if (size < 64)
+        {
+            fillAVX(dst, value, size);
+            return;
+        }
+
+        const __m256i v = _mm256_set1_epi8(static_cast<char>(value));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), v);
+        size_t i = 32 - reinterpret_cast<uintptr_t>(dst) % 32;
+
+        for (; i + 32 <= size; i += 32)
+        {
+            _mm256_stream_si256(reinterpret_cast<__m256i *>(dst + i), v);
+        }
+
+        _mm_sfence();
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + size - 32), v);
+    }
+};
+
+
+class AVX512FCopyTest
+    : public AVXCopyTest
+{
+public:
+    static const size_t simd_width = 64;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual int engineCount() const override { return 6; }
+
+    virtual const char *engineName(int engine) const override
+    {
+        switch (engine)
+        {
+        case 4: return "avx-512";
+        case 5: return "avx-512 stream";
+        default: return AVXCopyTest::engineName(engine);
+        }
+    }
+
+    virtual void copy(int engine, void *dst, const void *src, size_t size) const override
+    {
+        switch (engine)
+        {
+        case 4:
+            copyAVX512(static_cast<char *>(dst), static_cast<const char *>(src), size);
+            break;
+        case 5:
+            streamAVX512(static_cast<char *>(dst), static_cast<const char *>(src), size);
+            break;
+        default:
+            AVXCopyTest::copy(engine, dst, src, size);
+            break;
+        }
+    }
+
+    virtual void fill(int engine, void *dst, int value, size_t size) const override
+    {
+        switch (engine)
+        {
+        case 4:
+            fillAVX512(static_cast<char *>(dst), value, size);
+            break;
+        case 5:
+            streamFillAVX512(static_cast<char *>(dst), value, size);
+            break;
+        default:
+            AVXCopyTest::fill(engine, dst, value, size);
+            break;
+        }
+    }
+
+    static void copyAVX512(char *dst, const char *src, size_t size)
+    {
+        if (size < 64)
+        {
+            copyAVX(dst, src, size);
+            return;
+        }
+
+        const __m512i tail = _mm512_loadu_si512(src + size - 64);
+        size_t i = 0;
+
+        for (; i + 256 <= size; i += 256)
+        {
+            const __m512i a0 = _mm512_loadu_si512(src + i + 0x00);
+            const __m512i a1 = _mm512_loadu_si512(src + i + 0x40);
+            const __m512i a2 = _mm512_loadu_si512(src + i + 0x80);
+            const __m512i a3 = _mm512_loadu_si512(src + i + 0xc0);
+            _mm512_storeu_si512(dst + i + 0x00, a0);
+            _mm512_storeu_si512(dst + i + 0x40, a1);
+            _mm512_storeu_si512(dst + i + 0x80, a2);
+            _mm512_storeu_si512(dst + i + 0xc0, a3);
+        }
+        for (; i + 64 <= size; i += 64)
+        {
+            _mm512_storeu_si512(dst + i, _mm512_loadu_si512(src + i));
+        }
+
+        _mm512_storeu_si512(dst + size - 64, tail);
+    }
+
+    static void streamAVX512(char *dst, const char *src, size_t size)
+    {
+        if (size < 128)
+        {
+            copyAVX512(dst, src, size);
+            return;
+        }
+
+        const __m512i head = _mm512_loadu_si512(src);
+        const __m512i tail = _mm512_loadu_si512(src + size - 64);
+        _mm512_storeu_si512(dst, head);
+        size_t i = 64 - reinterpret_cast<uintptr_t>(dst) % 64;
+
+        for (; i + 256 <= size; i += 256)
+        {
+            const __m512i a0 = _mm512_loadu_si512(src + i + 0x00);
+            const __m512i a1 = _mm512_loadu_si512(src + i + 0x40);
+            const __m512i a2 = _mm512_loadu_si512(src + i + 0x80);
+            const __m512i a3 = _mm512_loadu_si512(src + i + 0xc0);
+            _mm512_stream_si512(reinterpret_cast<__m512i *>(dst + i + 0x00), a0);
+            _mm512_stream_si512(reinterpret_cast<__m512i *>(dst + i + 0x40), a1);
+            _mm512_stream_si512(reinterpret_cast<__m512i *>(dst + i + 0x80), a2);
+            _mm512_stream_si512(reinterpret_cast<__m512i *>(dst + i + 0xc0), a3);
+        }
+        for (; i + 64 <= size; i += 64)
+        {
+            _mm512_stream_si512(reinterpret_cast<__m512i *>(dst + i), _mm512_loadu_si512(src + i));
+        }
+
+        _mm_sfence();
+        _mm512_storeu_si512(dst + size - 64, tail);
+    }
+
+    static void fillAVX512(char *dst, int value, size_t size)
+    {
+        if (size < 64)
+        {
+            fillAVX(dst, value, size);
+            return;
+        }
+
+        const __m512i v = _mm512_set1_epi32(0x01010101 * (value & 0xff));
+        size_t i = 0;
+
+        for (; i + 256 <= size; i += 256)
+        {
+            _mm512_storeu_si512(dst + i + 0x00, v);
+            _mm512_storeu_si512(dst + i + 0x40, v);
+            _mm512_storeu_si512(dst + i + 0x80, v);
+            _mm512_storeu_si512(dst + i + 0xc0, v);
+        }
+        for (; i + 64 <= size; i += 64)
+        {
+            _mm512_storeu_si512(dst + i, v);
+        }
+
+        _mm512_storeu_si512(dst + size - 64, v);
+    }
+
+    static void streamFillAVX512(char *dst, int value, size_t size)
+    {
+        if (size < 128)
+        {
+            fillAVX512(dst, value, size);
+            return;
+        }
+
+        const __m512i v = _mm512_set1_epi32(0x01010101 * (value & 0xff));
+        _mm512_storeu_si512(dst, v);
+        size_t i = 64 - reinterpret_cast<uintptr_t>(dst) % 64;
+
+        for (; i + 64 <= size; i += 64)
+        {
+            _mm512_stream_si512(reinterpret_cast<__m512i *>(dst + i), v);
+        }
+
+        _mm_sfence();
+        _mm512_storeu_si512(dst + size - 64, v);
+    }
+};
@@ -0,0 +1,531 @@
+#pragma once
+
+#include "instruction_test.hpp"
+#include <cmath>
+
+// Blocked SGEMM (C += A * B, column-major) with packing and a register-blocked micro-kernel
+class GemmTest
+    : public InstructionTest
+{
+public:
+    int tile_vectors = 2; // MR = tile_vectors * SIMD lanes
+    int tile_columns = 6; // NR
+    int unroll = 4; // unrolling of the K loop in the micro-kernel
+    int kc = 256; // cache blocking: KC for L1, MC for L2, NC for L3
+    int mc = 128;
+    int nc = 2048;
+    std::vector<int> sizes = { 32, 64, 128, 256, 384, 512, 768, 1024, 1536, 2048 };
+    double flops_per_size = 4e9; // floating-point operations of each measurement
+
+    // whether the tile and unrolling have a micro-kernel in this mode
+    bool SupportsTile() const
+    {
+        return selectKernel() != nullptr;
+    }
+
+    virtual void RunTest() override
+    {
+        const MicroKernel micro_kernel = selectKernel();
+
+        if (micro_kernel == nullptr)
+        {
+            if (!silent) std::cout << "tile=" << tile_vectors << "x" << tile_columns << " unroll=" << unroll
+                << " is not supported by this mode!\n";
+            return;
+        }
+
+        // FMA peak of type 1 in the same environment
+        const double peak = measurePeak();
+
+        const int threads_new = beginTest();
+        const int mr = tile_vectors * static_cast<int>(simdWidth() / sizeof(float));
+        const int nr = tile_columns;
+
+        times = 0;
+        results.clear();
+
+        while (repeat <= 0 || times < repeat)
+        { // infinite loop for continuous tests
+            ++times;
+
+            if (!silent)
+            {
+                std::cout << times << ": SGEMM with " << mr << "x" << nr << " register tile, K loop unrolled by " << unroll
+                    << ", " << threads_new << " threads.\n"
+                    << std::setprecision(3) << "    Peak of type 1 is " << peak << " GFLOPS.\n"
+                    << "    size    working set (KiB)    threads      GFLOPS    % of peak\n";
+            }
+
+            for (const int n : sizes)
+            {
+                float *A = nullptr;
+                float *B = nullptr;
+                float *C = nullptr;
+                AlignedMalloc(A, static_cast<size_t>(n) * n, simdWidth());
+                AlignedMalloc(B, static_cast<size_t>(n) * n, simdWidth());
+                AlignedMalloc(C, static_cast<size_t>(n) * n, simdWidth());
+                fillMatrix(A, static_cast<size_t>(n) * n, 1);
+                fillMatrix(B, static_cast<size_t>(n) * n, 2);
+                std::fill(C, C + static_cast<size_t>(n) * n, 0.0f);
+
+                // warm up, and verify the result of the first run
+                gemm(micro_kernel, n, 1, A, B, C);
+                const bool valid = verify(n, A, B, C);
+
+                const double flops = 2.0 * n * n * n;
+                const int reps = std::max(1, static_cast<int>(flops_per_size / flops));
+                MyClock::time_point t1 = MyClock::now();
+                gemm(micro_kernel, n, reps, A, B, C);
+                MySeconds time_span = std::chrono::duration_cast<MySeconds>(MyClock::now() - t1);
+                const double gflops = flops * reps / (time_span.count() * 1e9);
+
+                // small sizes have fewer micro-tiles than threads, and are compared with the peak of the busy threads
+                const int busy = std::min(threads_new, tileCount(n));
+
+                if (!silent)
+                {
+                    std::cout << "    " << std::left << std::setw(8) << n << std::right
+                        << std::setw(17) << 3.0 * n * n * sizeof(float) / 1024
+                        << std::setw(11) << busy
+                        << std::setw(12) << gflops
+                        << std::setw(13) << gflops / (peak * busy / threads_new) * 100
+                        << (valid ? "" : "    wrong result!") << "\n";
+                }
+
+                AlignedFree(A);
+                AlignedFree(B);
+                AlignedFree(C);
+            }
+        }
+
+        endTest();
+    }
+
+protected:
+    // C(MR x NR) += packed A(MR x kc) * packed B(kc x NR)
+    typedef void (*MicroKernel)(int kc, const float *a, const float *b, float *c, size_t ldc);
+
+    // the micro-kernel of the configured tile and unrolling, nullptr if not supported
+    virtual MicroKernel selectKernel() const = 0;
+
+    // median GFLOPS of type 1 of the same instruction set
+    virtual double measurePeak() const = 0;
+
+    virtual void kernel() const override {}
+
+    // call f(0), f(1), ..., f(N - 1) with the loop fully unrolled at compile time,
+    // so that the accumulators of the micro-kernel can stay in registers
+    template < int N >
+    struct Unroll
+    {
+        template < typename _Fn >
+        static void run(_Fn f)
+        {
+            Unroll<N - 1>::run(f);
+            f(N - 1);
+        }
+    };
+
+    template < typename _Ty >
+    double runPeak() const
+    {
+        _Ty test;
+        test.silent = true;
+        test.threads = threads;
+        test.repeat = 3;
+        test.type = 1;
+        test.ftz_daz = ftz_daz;
+#ifdef _OPENMP
+        test.loop = 4 * (threads > 0 ? threads : omp_get_num_procs());
+#else
+        test.loop = 4;
+#endif
+        test.RunTest();
+        return test.MedianScore();
+    }
+
+    // micro-tiles in the largest MC x NC block, the work shared by the threads
+    int tileCount(int n) const
+    {
+        const int mr = tile_vectors * static_cast<int>(simdWidth() / sizeof(float));
+        const int nr = tile_columns;
+        const int mb = std::min(std::max(1, mc / mr) * mr, n);
+        const int nb = std::min(std::max(1, nc / nr) * nr, n);
+        return ((mb + mr - 1) / mr) * ((nb + nr - 1) / nr);
+    }
+
+    // C(n x n) += A * B for reps times
+    // the threads share the packed blocks, and split the micro-tiles of each block between them
+    void gemm(MicroKernel micro_kernel, int n, int reps, const float *A, const float *B, float *C) const
+    {
+        const int mr = tile_vectors * static_cast<int>(simdWidth() / sizeof(float));
+        const int nr = tile_columns;
+        const int mc_r = std::max(1, mc / mr) * mr;
+        const int nc_r = std::max(1, nc / nr) * nr;
+        float *a_pack = nullptr;
+        float *b_pack = nullptr;
+        AlignedMalloc(a_pack, static_cast<size_t>(mc_r) * kc, simdWidth());
+        AlignedMalloc(b_pack, static_cast<size_t>(kc) * nc_r, simdWidth());
+
+#pragma omp parallel
+        {
+            const unsigned int csr = SetFlushDenormals(ftz_daz);
+            alignas(64) float c_edge[16 * 64];
+
+            for (int r = 0; r < reps; ++r)
+            {
+                for (int jc = 0; jc < n; jc += nc_r)
+                {
+                    const int nb = std::min(nc_r, n - jc);
+
+                    for (int pc = 0; pc < n; pc += kc)
+                    {
+                        const int kb = std::min(kc, n - pc);
+
+                        // pack B(kb x nb) into panels of NR columns
+#pragma omp for
+                        for (int jr = 0; jr < nb; jr += nr)
+                        {
+                            packB(B + pc + static_cast<size_t>(jc + jr) * n, n, kb, std::min(nr, nb - jr), nr, b_pack + static_cast<size_t>(jr) * kb);
+                        }
+
+                        for (int ic = 0; ic < n; ic += mc_r)
+                        {
+                            const int mb = std::min(mc_r, n - ic);
+
+                            // pack A(mb x kb) into panels of MR rows
+#pragma omp for
+                            for (int ir = 0; ir < mb; ir += mr)
+                            {
+                                packA(A + ic + ir + static_cast<size_t>(pc) * n, n, std::min(mr, mb - ir), kb, mr, a_pack + static_cast<size_t>(ir) * kb);
+                            }
+
+                            // the MR x NR micro-tiles of the block, those of an NR panel on neighbouring threads
+                            const int m_tiles = (mb + mr - 1) / mr;
+                            const int tiles = m_tiles * ((nb + nr - 1) / nr);
+
+#pragma omp for
+                            for (int t = 0; t < tiles; ++t)
+                            {
+                                const int ir = t % m_tiles * mr;
+                                const int jr = t / m_tiles * nr;
+                                const float *a = a_pack + static_cast<size_t>(ir) * kb;
+                                const float *b = b_pack + static_cast<size_t>(jr) * kb;
+                                float *c = C + ic + ir + static_cast<size_t>(jc + jr) * n;
+                                const int m_valid = std::min(mr, mb - ir);
+                                const int n_valid = std::min(nr, nb - jr);
+
+                                if (m_valid == mr && n_valid == nr)
+                                {
+                                    micro_kernel(kb, a, b, c, n);
+                                }
+                                else
+                                { // partial tile at the edges
+                                    std::fill(c_edge, c_edge + mr * nr, 0.0f);
+                                    micro_kernel(kb, a, b, c_edge, mr);
+                                    for (int j = 0; j < n_valid; ++j)
+                                    {
+                                        for (int i = 0; i < m_valid; ++i)
+                                        {
+                                            c[i + static_cast<size_t>(j) * n] += c_edge[i + j * mr];
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            _mm_setcsr(csr);
+        }
+
+        AlignedFree(a_pack);
+        AlignedFree(b_pack);
+    }
+
+    // rows x cols of A into a zero-padded panel of MR rows, each column contiguous
+    static void packA(const float *src, size_t lda, int rows, int cols, int mr, float *dst)
+    {
+        for (int p = 0; p < cols; ++p)
+        {
+            for (int i = 0; i < mr; ++i)
+            {
+                dst[i] = i < rows ? src[i + p * lda] : 0.0f;
+            }
+            dst += mr;
+        }
+    }
+
+    // rows x cols of B into a zero-padded panel of NR columns, each row contiguous
+    static void packB(const float *src, size_t ldb, int rows, int cols, int nr, float *dst)
+    {
+        for (int p = 0; p < rows; ++p)
+        {
+            for (int j = 0; j < nr; ++j)
+            {
+                dst[j] = j < cols ? src[p + j * ldb] : 0.0f;
+            }
+            dst += nr;
+        }
+    }
+
+    static void fillMatrix(float *dst, size_t count, unsigned int seed)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<float> dist(-1, 1);
+        for (size_t i = 0; i < count; ++i) dst[i] = dist(gen);
+    }
+
+    // compare some elements of C against the scalar product
+    static bool verify(int n, const float *A, const float *B, const float *C)
+    {
+        for (int s = 0; s < 16; ++s)
+        {
+            const int i = (s * 7919) % n;
+            const int j = (s * 104729) % n;
+            double sum = 0;
+            for (int p = 0; p < n; ++p)
+            {
+                sum += static_cast<double>(A[i + static_cast<size_t>(p) * n]) * B[p + static_cast<size_t>(j) * n];
+            }
+            if (std::abs(C[i + static_cast<size_t>(j) * n] - sum) > 1e-4 * n) return false;
+        }
+        return true;
+    }
+};
+
+template < >
+struct GemmTest::Unroll<0>
+{
+    template < typename _Fn >
+    static void run(_Fn) {}
+};
+
+
+class AVXGemmTest
+    : public GemmTest
+{
+public:
+    static const size_t simd_width = 32;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual double measurePeak() const override { return runPeak<AVXTest>(); }
+
+    template < int MV, int NR, int KU >
+    FLATTEN static void microKernel(int kc, const float *a, const float *b, float *c, size_t ldc)
+    {
+        static const int lanes = simd_width / sizeof(float);
+        static const int mr = MV * lanes;
+        __m256 acc[MV][NR];
+
+        Unroll<MV * NR>::run([&](int t) { acc[t / NR][t % NR] = _mm256_setzero_ps(); });
+
+        // rank-1 update of the MR x NR tile
+        auto step = [&](const float *ap, const float *bp)
+        {
+            __m256 av[MV];
+            Unroll<MV>::run([&](int v) { av[v] = _mm256_load_ps(ap + v * lanes); });
+            Unroll<NR>::run([&](int j)
+            {
+                const __m256 bv = _mm256_broadcast_ss(bp + j);
+                Unroll<MV>::run([&](int v) { acc[v][j] = _mm256_add_ps(_mm256_mul_ps(av[v], bv), acc[v][j]); });
+            });
+        };
+
+        int p = 0;
+        for (; p + KU <= kc; p += KU)
+        {
+            Unroll<KU>::run([&](int u) { step(a + (p + u) * mr, b + (p + u) * NR); });
+        }
+        for (; p < kc; ++p)
+        {
+            step(a + p * mr, b + p * NR);
+        }
+
+        Unroll<MV * NR>::run([&](int t)
+        {
+            float *cp = c + (t % MV) * lanes + (t / MV) * ldc;
+            _mm256_storeu_ps(cp, _mm256_add_ps(_mm256_loadu_ps(cp), acc[t % MV][t / MV]));
+        });
+    }
+
+    template < int MV, int NR >
+    static MicroKernel select(int unroll)
+    {
+        switch (unroll)
+        {
+        case 1: return &microKernel<MV, NR, 1>;
+        case 2: return &microKernel<MV, NR, 2>;
+        case 4: return &microKernel<MV, NR, 4>;
+        case 8: return &microKernel<MV, NR, 8>;
+        default: return nullptr;
+        }
+    }
+
+    // tiles fitting in 16 registers
+    virtual MicroKernel selectKernel() const override
+    {
+        if (tile_vectors == 1 && tile_columns == 8) return select<1, 8>(unroll);
+        if (tile_vectors == 2 && tile_columns == 4) return select<2, 4>(unroll);
+        if (tile_vectors == 2 && tile_columns == 6) return select<2, 6>(unroll);
+        if (tile_vectors == 3 && tile_columns == 4) return select<3, 4>(unroll);
+        return nullptr;
+    }
+};
+
+
+class AVX2GemmTest
+    : public GemmTest
+{
+public:
+    static const size_t simd_width = 32;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual double measurePeak() const override { return runPeak<AVX2Test>(); }
+
+    template < int MV, int NR, int KU >
+    FLATTEN static void microKernel(int kc, const float *a, const float *b, float *c, size_t ldc)
+    {
+        static const int lanes = simd_width / sizeof(float);
+        static const int mr = MV * lanes;
+        __m256 acc[MV][NR];
+
+        Unroll<MV * NR>::run([&](int t) { acc[t / NR][t % NR] = _mm256_setzero_ps(); });
+
+        // rank-1 update of the MR x NR tile
+        auto step = [&](const float *ap, const float *bp)
+        {
+            __m256 av[MV];
+            Unroll<MV>::run([&](int v) { av[v] = _mm256_load_ps(ap + v * lanes); });
+            Unroll<NR>::run([&](int j)
+            {
+                const __m256 bv = _mm256_broadcast_ss(bp + j);
+                Unroll<MV>::run([&](int v) { acc[v][j] = _mm256_fmadd_ps(av[v], bv, acc[v][j]); });
+            });
+        };
+
+        int p = 0;
+        for (; p + KU <= kc; p += KU)
+        {
+            Unroll<KU>::run([&](int u) { step(a + (p + u) * mr, b + (p + u) * NR); });
+        }
+        for (; p < kc; ++p)
+        {
+            step(a + p * mr, b + p * NR);
+        }
+
+        Unroll<MV * NR>::run([&](int t)
+        {
+            float *cp = c + (t % MV) * lanes + (t / MV) * ldc;
+            _mm256_storeu_ps(cp, _mm256_add_ps(_mm256_loadu_ps(cp), acc[t % MV][t / MV]));
+        });
+    }
+
+    template < int MV, int NR >
+    static MicroKernel select(int unroll)
+    {
+        switch (unroll)
+        {
+        case 1: return &microKernel<MV, NR, 1>;
+        case 2: return &microKernel<MV, NR, 2>;
+        case 4: return &microKernel<MV, NR, 4>;
+        case 8: return &microKernel<MV, NR, 8>;
+        default: return nullptr;
+        }
+    }
+
+    // tiles fitting in 16 registers
+    virtual MicroKernel selectKernel() const override
+    {
+        if (tile_vectors == 1 && tile_columns == 8) return select<1, 8>(unroll);
+        if (tile_vectors == 2 && tile_columns == 4) return select<2, 4>(unroll);
+        if (tile_vectors == 2 && tile_columns == 6) return select<2, 6>(unroll);
+        if (tile_vectors == 3 && tile_columns == 4) return select<3, 4>(unroll);
+        return nullptr;
+    }
+};
+
+
+class AVX512FGemmTest
+    : public GemmTest
+{
+public:
+    static const size_t simd_width = 64;
+
+    AVX512FGemmTest()
+    {
+        tile_columns = 12;
+    }
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual double measurePeak() const override { return runPeak<AVX512FTest>(); }
+
+    template < int MV, int NR, int KU >
+    FLATTEN static void microKernel(int kc, const float *a, const float *b, float *c, size_t ldc)
+    {
+        static const int lanes = simd_width / sizeof(float);
+        static const int mr = MV * lanes;
+        __m512 acc[MV][NR];
+
+        Unroll<MV * NR>::run([&](int t) { acc[t / NR][t % NR] = _mm512_setzero_ps(); });
+
+        // rank-1 update of the MR x NR tile
+        auto step = [&](const float *ap, const float *bp)
+        {
+            __m512 av[MV];
+            Unroll<MV>::run([&](int v) { av[v] = _mm512_load_ps(ap + v * lanes); });
+            Unroll<NR>::run([&](int j)
+            {
+                const __m512 bv = _mm512_set1_ps(bp[j]);
+                Unroll<MV>::run([&](int v) { acc[v][j] = _mm512_fmadd_ps(av[v], bv, acc[v][j]); });
+            });
+        };
+
+        int p = 0;
+        for (; p + KU <= kc; p += KU)
+        {
+            Unroll<KU>::run([&](int u) { step(a + (p + u) * mr, b + (p + u) * NR); });
+        }
+        for (; p < kc; ++p)
+        {
+            step(a + p * mr, b + p * NR);
+        }
+
+        Unroll<MV * NR>::run([&](int t)
+        {
+            float *cp = c + (t % MV) * lanes + (t / MV) * ldc;
+            _mm512_storeu_ps(cp, _mm512_add_ps(_mm512_loadu_ps(cp), acc[t % MV][t / MV]));
+        });
+    }
+
+    template < int MV, int NR >
+    static MicroKernel select(int unroll)
+    {
+        switch (unroll)
+        {
+        case 1: return &microKernel<MV, NR, 1>;
+        case 2: return &microKernel<MV, NR, 2>;
+        case 4: return &microKernel<MV, NR, 4>;
+        case 8: return &microKernel<MV, NR, 8>;
+        default: return nullptr;
+        }
+    }
+
+    // tiles fitting in 32 registers
+    virtual MicroKernel selectKernel() const override
+    {
+        if (tile_vectors == 1 && tile_columns == 8) return select<1, 8>(unroll);
+        if (tile_vectors == 2 && tile_columns == 6) return select<2, 6>(unroll);
+        if (tile_vectors == 2 && tile_columns == 12) return select<2, 12>(unroll);
+        if (tile_vectors == 3 && tile_columns == 8) return select<3, 8>(unroll);
+        if (tile_vectors == 4 && tile_columns == 6) return select<4, 6>(unroll);
+        return nullptr;
+    }
+};
@@ -2,7 +2,12 @@
 
 #include "utils.h"
 #include <string>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <cstring>
 #include <algorithm>
+#include <functional>
 #include <iostream>
 #include <iomanip>
 
@@ -14,34 +19,53 @@ public:
     size_t length = 0x1000000;
     int threads = 0;
     int loop = 0x1000;
+    int repeat = 0; // 0 means infinite repeats
     int type = 1;
+    int operand = 1; // operand values for type 1-3, see OperandName()
+    int denormal_ratio = 50; // percentage of denormals when operand=3
+    bool ftz_daz = false;
+
+    std::vector<double> results; // elapsed seconds of each repeat
+    std::function<void()> synchronize; // called before each repeat, such as to start processes in lockstep
 
 protected:
+    static const size_t operand_count = 128; // 8 registers of up to 16 floats
+    std::streamsize io_precision_origin;
+    int threads_origin;
+    unsigned int csr_origin;
     bool stress_test;
     int times;
     size_t _length;
+    float op_mul; // type 1: r = r * op_mul + op_add keeps the operands unchanged
+    float op_add;
+    float *vecOp = nullptr;
     float *vecA = nullptr;
     float *vecB = nullptr;
     float *vecC = nullptr;
     float *vecD = nullptr;
+    std::vector<float> reference; // sampled outputs of the first verified loop
+    mutable bool keep_results = false; // set by RunOnce(), never while the threads of kernel() run
+    mutable std::vector<float> kept_results; // type 1-2 accumulators of the last RunOnce()
 
 public:
     virtual ~InstructionTest() {}
 
-    void RunTest()
+    static const char *OperandName(int operand)
     {
-        // Standard I/O
-        const std::streamsize io_precision_origin = std::cout.precision();
-        std::fixed(std::cout);
+        switch (operand)
+        {
+        case 1: return "normal";
+        case 2: return "denormal";
+        case 3: return "mixed";
+        case 4: return "NaN/Inf";
+        case 5: return "zero";
+        default: return "unknown";
+        }
+    }
 
-        // OpenMP
-#ifdef _OPENMP
-        const int threads_origin = omp_get_max_threads();
-        const int threads_new = threads > 0 ? threads : std::max(1, omp_get_num_procs() - threads);
-        omp_set_num_threads(threads_new);
-#else
-        const int threads_new = 1;
-#endif
+    virtual void RunTest()
+    {
+        const int threads_new = beginTest();
 
         // Stress Test
         stress_test = false;
@@ -56,30 +80,15 @@ public:
 
         // Kernel
         times = 0;
+        results.clear();
 
-        // initialize
-        switch (type)
-        {
-        case 1:
-            _length = length * 16;
-            break;
-        case 2:
-            _length = length * 3;
-            AlignedMalloc(vecA, _length, simdWidth());
-            break;
-        case 3:
-            _length = length;
-            AlignedMalloc(vecA, _length, simdWidth());
-            AlignedMalloc(vecB, _length, simdWidth());
-            break;
-        default:
-            _length = length;
-            break;
-        }
+        InitTest();
 
         // run the tests
-        while (true)
+        while (repeat <= 0 || times < repeat)
         { // infinite loop for continuous tests
+            if (synchronize) synchronize();
+
             // start time
             MyClock::time_point t1 = MyClock::now();
 
@@ -89,6 +98,7 @@ public:
             // end time
             MySeconds time_span = std::chrono::duration_cast<MySeconds>(MyClock::now() - t1);
             ++times;
+            results.push_back(time_span.count());
 
             // output
             if (!silent)
@@ -97,9 +107,58 @@ public:
             }
         }
 
-        // free
+        ReleaseTest();
+
+        endTest();
+    }
+
+    // allocate and fill the data of the test type
+    void InitTest()
+    {
+        reference.clear();
+
         switch (type)
         {
+        case 1:
+            _length = length * 16;
+            op_mul = 1;
+            op_add = -0.0f;
+            AlignedMalloc(vecOp, operand_count, simdWidth());
+            fillOperands(vecOp, operand_count);
+            break;
+        case 2:
+            _length = length * 3;
+            AlignedMalloc(vecA, _length, simdWidth());
+            fillOperands(vecA, _length);
+            break;
+        case 3:
+            _length = length;
+            AlignedMalloc(vecA, _length, simdWidth());
+            AlignedMalloc(vecB, _length, simdWidth());
+            fillOperands(vecA, _length);
+            break;
+        default:
+            _length = length;
+            break;
+        }
+    }
+
+    // a single loop on the calling thread, between InitTest() and ReleaseTest()
+    void RunOnce() const
+    {
+        kept_results.clear();
+        keep_results = true;
+        iterate();
+        keep_results = false;
+    }
+
+    void ReleaseTest()
+    {
+        switch (type)
+        {
+        case 1:
+            AlignedFree(vecOp);
+            break;
         case 2:
             AlignedFree(vecA);
             break;
@@ -110,6 +169,139 @@ public:
         default:
             break;
         }
+    }
+
+    // whether Verify() checks the results of the type
+    bool Verifiable() const
+    {
+        return type >= 1 && type <= 3;
+    }
+
+    // number of results of RunOnce() that differ from the first call, to catch silent data corruption:
+    // the accumulators for type 1-2, which are deterministic on a single thread, and sampled outputs for type 3
+    size_t Verify()
+    {
+        if (type == 1 || type == 2)
+        {
+            if (reference.empty())
+            {
+                reference = kept_results;
+                return 0;
+            }
+            if (kept_results.size() != reference.size()) return std::max(kept_results.size(), reference.size());
+
+            size_t errors = 0;
+            for (size_t i = 0; i < reference.size(); ++i)
+            {
+                if (std::memcmp(&kept_results[i], &reference[i], sizeof(float))) ++errors;
+            }
+            return errors;
+        }
+
+        if (type != 3) return 0;
+
+        static const size_t stride = 0x400; // one float per 4 KiB
+        size_t errors = 0;
+
+        if (reference.empty())
+        {
+            for (size_t i = 0; i < _length; i += stride) reference.push_back(vecB[i]);
+        }
+        else
+        {
+            for (size_t i = 0, k = 0; i < _length; i += stride, ++k)
+            {
+                if (std::memcmp(vecB + i, &reference[k], sizeof(float))) ++errors;
+            }
+        }
+
+        return errors;
+    }
+
+    // floating-point operations of a single loop, 0 for type 4-5
+    double LoopFlops() const
+    {
+        return type >= 1 && type <= 3 ? 2.0 * _length : 0;
+    }
+
+    // bytes of memory read and written by a single loop
+    double LoopBytes() const
+    {
+        switch (type)
+        {
+        case 2:
+            return static_cast<double>(_length) * sizeof(float);
+        case 3:
+            return 2.0 * _length * sizeof(float);
+        default:
+            return 0;
+        }
+    }
+
+    // GFLOPS for type 1-3, average batch time (microseconds) for type 4-5
+    double Score(double seconds) const
+    {
+        switch (type)
+        {
+        case 1:
+        case 2:
+        case 3:
+            return 2 * _length * loop / (seconds * 1e9);
+        case 4:
+        case 5:
+            return seconds * 1e6 / loop;
+        default:
+            return 0;
+        }
+    }
+
+    // median score of all the repeats in the last run
+    double MedianScore() const
+    {
+        return results.empty() ? 0 : Score(Median(results));
+    }
+
+    // parameters identifying the results of the last run
+    std::string Parameters() const
+    {
+        return "type=" + std::to_string(type)
+            + " threads=" + std::to_string(threads)
+            + " loop=" + std::to_string(loop)
+            + " length=" + std::to_string(length)
+            + " batch=" + std::to_string(batch)
+            + " operand=" + std::to_string(operand)
+            + " denormal_ratio=" + std::to_string(denormal_ratio)
+            + " ftz_daz=" + std::to_string(ftz_daz ? 1 : 0);
+    }
+
+protected:
+    // set up the I/O, OpenMP and FP environment, and return the number of threads to use
+    int beginTest()
+    {
+        // Standard I/O
+        io_precision_origin = std::cout.precision();
+        std::fixed(std::cout);
+
+        // OpenMP
+#ifdef _OPENMP
+        threads_origin = omp_get_max_threads();
+        const int threads_new = threads > 0 ? threads : std::max(1, omp_get_num_procs() - threads);
+        omp_set_num_threads(threads_new);
+#else
+        const int threads_new = 1;
+#endif
+
+        // FP environment of the calling thread (MXCSR is per thread, each parallel region sets its own threads)
+        csr_origin = SetFlushDenormals(ftz_daz);
+
+        return threads_new;
+    }
+
+    // restore the environment changed by beginTest()
+    void endTest()
+    {
+        // FP environment
+        _mm_setcsr(csr_origin);
 
         // OpenMP
 #ifdef _OPENMP
@@ -121,10 +313,28 @@ public:
         std::defaultfloat(std::cout);
     }
 
-protected:
     virtual size_t simdWidth() const = 0;
 
-    virtual void kernel() const = 0;
+    // run the loops on all the threads
+    virtual void kernel() const
+    {
+#pragma omp parallel
+        {
+            // in the same region as the loops, as the runtime may start other threads for each region
+            const unsigned int csr = SetFlushDenormals(ftz_daz);
+
+#pragma omp for
+            for (int l = 0; l < loop; ++l)
+            { // main loop
+                do iterate(); while (stress_test); // infinite loop when doing stress test
+            }
+
+            _mm_setcsr(csr);
+        }
+    }
+
+    // a single loop of the test type
+    virtual void iterate() const {}
 
     virtual void output(const MySeconds &time_span) const
     {
@@ -139,20 +349,79 @@ protected:
         case 3:
             std::cout << std::setprecision(6)
                 << "    Achieving "
-                << 2 * _length * loop / std::chrono::duration_cast<MyNanoseconds>(time_span).count()
+                << Score(time_span.count())
                 << " GFLOPS (single precision).\n";
             break;
         case 4:
         case 5:
             std::cout << std::setprecision(3)
                 << "    Average batch time (per loop) is "
-                << std::chrono::duration_cast<MyMicroseconds>(time_span).count() / loop
+                << Score(time_span.count())
                 << " microseconds.\n";
             break;
         default:
             break;
         }
     }
+
+    // read the results, so that the compiler can't eliminate the kernel
+    static void consume(const float *mem, size_t count)
+    {
+        volatile float sink = 0;
+        for (size_t i = 0; i < count; ++i) sink = sink + mem[i];
+    }
+
+    static void consume(const int32_t *mem, size_t count)
+    {
+        volatile int32_t sink = 0;
+        for (size_t i = 0; i < count; ++i) sink = sink ^ mem[i];
+    }
+
+    // consume(), and keep the results for Verify() when called from RunOnce()
+    void consumeResult(const float *mem, size_t count) const
+    {
+        consume(mem, count);
+        if (keep_results) kept_results.insert(kept_results.end(), mem, mem + count);
+    }
+
+    // fill the operands with values of the given distribution
+    // the generator is seeded with a constant, so that every run sees the same data
+    void fillOperands(float *dst, size_t count) const
+    {
+        std::mt19937 gen(0x5EED);
+        std::uniform_real_distribution<float> normal_dist(0.5f, 2.0f);
+        std::uniform_int_distribution<uint32_t> denormal_dist(1, 0x007FFFFF);
+        std::uniform_int_distribution<int> percent_dist(0, 99);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint32_t sign = i % 2 ? 0x80000000 : 0;
+            const float value = normal_dist(gen);
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            bits |= sign;
+
+            switch (operand)
+            {
+            case 2: // denormal
+                bits = sign | denormal_dist(gen);
+                break;
+            case 3: // mixed normal/denormal
+                if (percent_dist(gen) < denormal_ratio) bits = sign | denormal_dist(gen);
+                break;
+            case 4: // NaN/Inf
+                bits = i % 3 == 0 ? 0x7FC00000 : sign | 0x7F800000;
+                break;
+            case 5: // zero
+                bits = sign;
+                break;
+            default: // normal
+                break;
+            }
+
+            std::memcpy(dst + i, &bits, sizeof(bits));
+        }
+    }
 };
 
 
@@ -166,174 +435,177 @@ public:
 protected:
     virtual size_t simdWidth() const override { return simd_width; }
 
-    virtual void kernel() const override
+    virtual void iterate() const override
     {
-#pragma omp parallel for
-        for (int l = 0; l < loop; ++l)
-        { // main loop
-            do switch (type)
-            {
-            case 1:
+        switch (type)
+        {
+        case 1:
+        {
+            static const int batch = 8;
+            static const size_t simd_step = simd_width * batch / sizeof(float);
+            static const size_t simd_step1 = simd_width / sizeof(float);
+            const __m256 m = _mm256_set1_ps(op_mul);
+            const __m256 z = _mm256_set1_ps(op_add);
+            __m256 r0 = _mm256_load_ps(vecOp + simd_step1 * 0);
+            __m256 r1 = _mm256_load_ps(vecOp + simd_step1 * 1);
+            __m256 r2 = _mm256_load_ps(vecOp + simd_step1 * 2);
+            __m256 r3 = _mm256_load_ps(vecOp + simd_step1 * 3);
+            __m256 r4 = _mm256_load_ps(vecOp + simd_step1 * 4);
+            __m256 r5 = _mm256_load_ps(vecOp + simd_step1 * 5);
+            __m256 r6 = _mm256_load_ps(vecOp + simd_step1 * 6);
+            __m256 r7 = _mm256_load_ps(vecOp + simd_step1 * 7);
+
+            for (size_t i = 0; i < _length; i += simd_step)
             {
-                static const int batch = 8;
-                static const size_t simd_step = simd_width * batch / sizeof(float);
-                __m256 r0 = _mm256_setzero_ps();
-                __m256 r1 = _mm256_setzero_ps();
-                __m256 r2 = _mm256_setzero_ps();
-                __m256 r3 = _mm256_setzero_ps();
-                __m256 r4 = _mm256_setzero_ps();
-                __m256 r5 = _mm256_setzero_ps();
-                __m256 r6 = _mm256_setzero_ps();
-                __m256 r7 = _mm256_setzero_ps();
-
-                for (size_t i = 0; i < _length; i += simd_step)
-                {
-                    r0 = _mm256_mul_ps(r0, r0); r0 = _mm256_add_ps(r0, r0);
-                    r1 = _mm256_mul_ps(r1, r1); r1 = _mm256_add_ps(r1, r1);
-                    r2 = _mm256_mul_ps(r2, r2); r2 = _mm256_add_ps(r2, r2);
-                    r3 = _mm256_mul_ps(r3, r3); r3 = _mm256_add_ps(r3, r3);
-                    r4 = _mm256_mul_ps(r4, r4); r4 = _mm256_add_ps(r4, r4);
-                    r5 = _mm256_mul_ps(r5, r5); r5 = _mm256_add_ps(r5, r5);
-                    r6 = _mm256_mul_ps(r6, r6); r6 = _mm256_add_ps(r6, r6);
-                    r7 = _mm256_mul_ps(r7, r7); r7 = _mm256_add_ps(r7, r7);
-                }
-
-                alignas(simd_width) float mem[simd_width * batch];
-                _mm256_store_ps(mem + simd_width * 0x0, r0);
-                _mm256_store_ps(mem + simd_width * 0x1, r1);
-                _mm256_store_ps(mem + simd_width * 0x2, r2);
-                _mm256_store_ps(mem + simd_width * 0x3, r3);
-                _mm256_store_ps(mem + simd_width * 0x4, r4);
-                _mm256_store_ps(mem + simd_width * 0x5, r5);
-                _mm256_store_ps(mem + simd_width * 0x6, r6);
-                _mm256_store_ps(mem + simd_width * 0x7, r7);
-
-                break;
+                r0 = _mm256_mul_ps(r0, m); r0 = _mm256_add_ps(r0, z);
+                r1 = _mm256_mul_ps(r1, m); r1 = _mm256_add_ps(r1, z);
+                r2 = _mm256_mul_ps(r2, m); r2 = _mm256_add_ps(r2, z);
+                r3 = _mm256_mul_ps(r3, m); r3 = _mm256_add_ps(r3, z);
+                r4 = _mm256_mul_ps(r4, m); r4 = _mm256_add_ps(r4, z);
+                r5 = _mm256_mul_ps(r5, m); r5 = _mm256_add_ps(r5, z);
+                r6 = _mm256_mul_ps(r6, m); r6 = _mm256_add_ps(r6, z);
+                r7 = _mm256_mul_ps(r7, m); r7 = _mm256_add_ps(r7, z);
             }
-            case 2:
-            {
-                static const int batch = 4;
-                static const size_t simd_step1 = simd_width / sizeof(float);
-                static const size_t simd_step2 = simd_step1 * batch;
-
-                const float *vecA0 = vecA + simd_step1 * 0;
-                const float *vecA1 = vecA + simd_step1 * 1;
-                const float *vecA2 = vecA + simd_step1 * 2;
-                const float *vecA3 = vecA + simd_step1 * 3;
-
-                __m256 b0 = _mm256_setzero_ps();
-                __m256 b1 = _mm256_setzero_ps();
-                __m256 b2 = _mm256_setzero_ps();
-                __m256 b3 = _mm256_setzero_ps();
-
-                for (size_t i = 0; i < _length; i += simd_step2)
-                {
-                    const __m256 a0 = _mm256_load_ps(vecA0 + i);
-                    const __m256 a1 = _mm256_load_ps(vecA1 + i);
-                    const __m256 a2 = _mm256_load_ps(vecA2 + i);
-                    const __m256 a3 = _mm256_load_ps(vecA3 + i);
-
-                    b0 = _mm256_add_ps(_mm256_mul_ps(a0, a0), b0);
-                    b1 = _mm256_add_ps(_mm256_mul_ps(a1, a1), b1);
-                    b2 = _mm256_add_ps(_mm256_mul_ps(a2, a2), b2);
-                    b3 = _mm256_add_ps(_mm256_mul_ps(a3, a3), b3);
-                }
-
-                const __m256 b = _mm256_add_ps(_mm256_add_ps(b0, b1), _mm256_add_ps(b2, b3));
-                alignas(simd_width) float mem[simd_width];
-                _mm256_store_ps(mem, b);
 
-                break;
-            }
-            case 3:
-            {
-                static const size_t simd_step = simd_width / sizeof(float);
+            alignas(simd_width) float mem[simd_width * batch];
+            _mm256_store_ps(mem + simd_width * 0x0, r0);
+            _mm256_store_ps(mem + simd_width * 0x1, r1);
+            _mm256_store_ps(mem + simd_width * 0x2, r2);
+            _mm256_store_ps(mem + simd_width * 0x3, r3);
+            _mm256_store_ps(mem + simd_width * 0x4, r4);
+            _mm256_store_ps(mem + simd_width * 0x5, r5);
+            _mm256_store_ps(mem + simd_width * 0x6, r6);
+            _mm256_store_ps(mem + simd_width * 0x7, r7);
+            for (int k = 0; k < batch; ++k) consumeResult(mem + simd_width * k, simd_step1);
 
-                for (size_t i = 0; i < _length; i += simd_step)
-                {
-                    const __m256 a = _mm256_load_ps(vecA + i);
-                    const __m256 b = _mm256_add_ps(_mm256_mul_ps(a, a), a);
-                    _mm256_store_ps(vecB + i, b);
-                }
+            break;
+        }
+        case 2:
+        {
+            static const int batch = 4;
+            static const size_t simd_step1 = simd_width / sizeof(float);
+            static const size_t simd_step2 = simd_step1 * batch;
 
-                break;
+            const float *vecA0 = vecA + simd_step1 * 0;
+            const float *vecA1 = vecA + simd_step1 * 1;
+            const float *vecA2 = vecA + simd_step1 * 2;
+            const float *vecA3 = vecA + simd_step1 * 3;
+
+            __m256 b0 = _mm256_setzero_ps();
+            __m256 b1 = _mm256_setzero_ps();
+            __m256 b2 = _mm256_setzero_ps();
+            __m256 b3 = _mm256_setzero_ps();
+
+            for (size_t i = 0; i < _length; i += simd_step2)
+            {
+                const __m256 a0 = _mm256_load_ps(vecA0 + i);
+                const __m256 a1 = _mm256_load_ps(vecA1 + i);
+                const __m256 a2 = _mm256_load_ps(vecA2 + i);
+                const __m256 a3 = _mm256_load_ps(vecA3 + i);
+
+                b0 = _mm256_add_ps(_mm256_mul_ps(a0, a0), b0);
+                b1 = _mm256_add_ps(_mm256_mul_ps(a1, a1), b1);
+                b2 = _mm256_add_ps(_mm256_mul_ps(a2, a2), b2);
+                b3 = _mm256_add_ps(_mm256_mul_ps(a3, a3), b3);
             }
-            case 4:
+
+            const __m256 b = _mm256_add_ps(_mm256_add_ps(b0, b1), _mm256_add_ps(b2, b3));
+            alignas(simd_width) float mem[simd_width];
+            _mm256_store_ps(mem, b);
+            consumeResult(mem, simd_step1);
+
+            break;
+        }
+        case 3:
+        {
+            static const size_t simd_step = simd_width / sizeof(float);
+
+            for (size_t i = 0; i < _length; i += simd_step)
             {
-                const __m256 c0 = _mm256_setzero_ps();
-                const __m256 c1 = _mm256_set1_ps(1);
-                const __m256 c2 = _mm256_set_ps(1, 2, 4, 8, 16, 32, 64, 128);
-                const __m256 c3 = _mm256_set_ps(128, 64, 32, 16, 8, 4, 2, 1);
-
-                __m256 r0 = c2;
-                __m256 r1 = c3;
-                __m256 r2, r3;
-
-                for (int j = 0; j < batch; ++j)
-                { // loop for batch
-                  // Arithmetic
-                    r2 = _mm256_add_ps(r0, r1);
-                    r3 = _mm256_sub_ps(r0, r1);
-                    r0 = _mm256_mul_ps(r2, r3);
-                    // Special Math Functions
-                    r2 = _mm256_min_ps(r0, r1);
-                    r3 = _mm256_max_ps(r0, r1);
-                    // Swizzle
-                    r0 = _mm256_unpacklo_ps(r2, r3);
-                    r1 = _mm256_unpackhi_ps(r2, r3);
-                }
-
-                alignas(simd_width) float mem[simd_width / 2];
-                _mm256_store_ps(mem, r0);
-                _mm256_store_ps(mem + simd_width / 4, r1);
+                const __m256 a = _mm256_load_ps(vecA + i);
+                const __m256 b = _mm256_add_ps(_mm256_mul_ps(a, a), a);
+                _mm256_store_ps(vecB + i, b);
+            }
 
-                break;
+            break;
+        }
+        case 4:
+        {
+            const __m256 c0 = _mm256_setzero_ps();
+            const __m256 c1 = _mm256_set1_ps(1);
+            const __m256 c2 = _mm256_set_ps(1, 2, 4, 8, 16, 32, 64, 128);
+            const __m256 c3 = _mm256_set_ps(128, 64, 32, 16, 8, 4, 2, 1);
+
+            __m256 r0 = c2;
+            __m256 r1 = c3;
+            __m256 r2, r3;
+
+            for (int j = 0; j < batch; ++j)
+            { // loop for batch
+              // Arithmetic
+                r2 = _mm256_add_ps(r0, r1);
+                r3 = _mm256_sub_ps(r0, r1);
+                r0 = _mm256_mul_ps(r2, r3);
+                // Special Math Functions
+                r2 = _mm256_min_ps(r0, r1);
+                r3 = _mm256_max_ps(r0, r1);
+                // Swizzle
+                r0 = _mm256_unpacklo_ps(r2, r3);
+                r1 = _mm256_unpackhi_ps(r2, r3);
             }
-            case 5:
-            {
-                const __m256 c0 = _mm256_setzero_ps();
-                const __m256 c1 = _mm256_set1_ps(1);
-                const __m256 c2 = _mm256_set_ps(1, 2, 4, 8, 16, 32, 64, 128);
-                const __m256 c3 = _mm256_set_ps(128, 64, 32, 16, 8, 4, 2, 1);
-
-                __m256 r0 = c2;
-                __m256 r1 = c3;
-                __m256 r2, r3;
-
-                for (int j = 0; j < batch; ++j)
-                { // loop for batch
-                  // Arithmetic
-                    r2 = _mm256_add_ps(r0, r1);
-                    r3 = _mm256_sub_ps(r0, r1);
-                    r0 = _mm256_hadd_ps(r2, r3);
-                    r1 = _mm256_mul_ps(r2, r3);
-                    // Logical
-                    r2 = _mm256_and_ps(r0, r1);
-                    r3 = _mm256_or_ps(r0, r1);
-                    r0 = _mm256_andnot_ps(r2, r3);
-                    r1 = _mm256_xor_ps(r2, r3);
-                    // Special Math Functions
-                    r2 = _mm256_min_ps(r0, r1);
-                    r3 = _mm256_max_ps(r0, r1);
-                    r0 = _mm256_floor_ps(r2);
-                    r1 = _mm256_ceil_ps(r3);
-                    // Swizzle
-                    r2 = _mm256_unpackhi_ps(r0, r1);
-                    r3 = _mm256_unpacklo_ps(r0, r1);
-                    r0 = _mm256_shuffle_ps(r2, r3, 0xaa);
-                    r1 = _mm256_blend_ps(r2, r3, 0x55);
-                }
-
-                alignas(simd_width) float mem[simd_width / 2];
-                _mm256_store_ps(mem, r0);
-                _mm256_store_ps(mem + simd_width / 4, r1);
 
-                break;
+            alignas(simd_width) float mem[simd_width / 2];
+            _mm256_store_ps(mem, r0);
+            _mm256_store_ps(mem + simd_width / 4, r1);
+            consume(mem, simd_width / 2);
+
+            break;
+        }
+        case 5:
+        {
+            const __m256 c0 = _mm256_setzero_ps();
+            const __m256 c1 = _mm256_set1_ps(1);
+            const __m256 c2 = _mm256_set_ps(1, 2, 4, 8, 16, 32, 64, 128);
+            const __m256 c3 = _mm256_set_ps(128, 64, 32, 16, 8, 4, 2, 1);
+
+            __m256 r0 = c2;
+            __m256 r1 = c3;
+            __m256 r2, r3;
+
+            for (int j = 0; j < batch; ++j)
+            { // loop for batch
+              // Arithmetic
+                r2 = _mm256_add_ps(r0, r1);
+                r3 = _mm256_sub_ps(r0, r1);
+                r0 = _mm256_hadd_ps(r2, r3);
+                r1 = _mm256_mul_ps(r2, r3);
+                // Logical
+                r2 = _mm256_and_ps(r0, r1);
+                r3 = _mm256_or_ps(r0, r1);
+                r0 = _mm256_andnot_ps(r2, r3);
+                r1 = _mm256_xor_ps(r2, r3);
+                // Special Math Functions
+                r2 = _mm256_min_ps(r0, r1);
+                r3 = _mm256_max_ps(r0, r1);
+                r0 = _mm256_floor_ps(r2);
+                r1 = _mm256_ceil_ps(r3);
+                // Swizzle
+                r2 = _mm256_unpackhi_ps(r0, r1);
+                r3 = _mm256_unpacklo_ps(r0, r1);
+                r0 = _mm256_shuffle_ps(r2, r3, 0xaa);
+                r1 = _mm256_blend_ps(r2, r3, 0x55);
             }
-            default:
-                if (!silent) std::cout << "type=" << type << " is not supported by this mode!";
-                break;
-            } while (stress_test); // infinite loop when doing stress test
+
+            alignas(simd_width) float mem[simd_width / 2];
+            _mm256_store_ps(mem, r0);
+            _mm256_store_ps(mem + simd_width / 4, r1);
+            consume(mem, simd_width / 2);
+
+            break;
+        }
+        default:
+            if (!silent) std::cout << "type=" << type << " is not supported by this mode!";
+            break;
         }
     }
 };
@@ -348,172 +620,175 @@ public:
 protected:
     virtual size_t simdWidth() const override { return simd_width; }
 
-    virtual void kernel() const override
+    virtual void iterate() const override
     {
-#pragma omp parallel for
-        for (int l = 0; l < loop; ++l)
-        { // main loop
-            do switch (type)
-            {
-            case 1:
+        switch (type)
+        {
+        case 1:
+        {
+            static const int batch = 8;
+            static const size_t simd_step = simd_width * batch / sizeof(float);
+            static const size_t simd_step1 = simd_width / sizeof(float);
+            const __m256 m = _mm256_set1_ps(op_mul);
+            const __m256 z = _mm256_set1_ps(op_add);
+            __m256 r0 = _mm256_load_ps(vecOp + simd_step1 * 0);
+            __m256 r1 = _mm256_load_ps(vecOp + simd_step1 * 1);
+            __m256 r2 = _mm256_load_ps(vecOp + simd_step1 * 2);
+            __m256 r3 = _mm256_load_ps(vecOp + simd_step1 * 3);
+            __m256 r4 = _mm256_load_ps(vecOp + simd_step1 * 4);
+            __m256 r5 = _mm256_load_ps(vecOp + simd_step1 * 5);
+            __m256 r6 = _mm256_load_ps(vecOp + simd_step1 * 6);
+            __m256 r7 = _mm256_load_ps(vecOp + simd_step1 * 7);
+
+            for (size_t i = 0; i < _length; i += simd_step)
             {
-                static const int batch = 8;
-                static const size_t simd_step = simd_width * batch / sizeof(float);
-                __m256 r0 = _mm256_setzero_ps();
-                __m256 r1 = _mm256_setzero_ps();
-                __m256 r2 = _mm256_setzero_ps();
-                __m256 r3 = _mm256_setzero_ps();
-                __m256 r4 = _mm256_setzero_ps();
-                __m256 r5 = _mm256_setzero_ps();
-                __m256 r6 = _mm256_setzero_ps();
-                __m256 r7 = _mm256_setzero_ps();
-
-                for (size_t i = 0; i < _length; i += simd_step)
-                {
-                    r0 = _mm256_fmadd_ps(r0, r0, r0);
-                    r1 = _mm256_fmadd_ps(r1, r1, r1);
-                    r2 = _mm256_fmadd_ps(r2, r2, r2);
-                    r3 = _mm256_fmadd_ps(r3, r3, r3);
-                    r4 = _mm256_fmadd_ps(r4, r4, r4);
-                    r5 = _mm256_fmadd_ps(r5, r5, r5);
-                    r6 = _mm256_fmadd_ps(r6, r6, r6);
-                    r7 = _mm256_fmadd_ps(r7, r7, r7);
-                }
-
-                alignas(simd_width) float mem[simd_width * batch];
-                _mm256_store_ps(mem + simd_width * 0x0, r0);
-                _mm256_store_ps(mem + simd_width * 0x1, r1);
-                _mm256_store_ps(mem + simd_width * 0x2, r2);
-                _mm256_store_ps(mem + simd_width * 0x3, r3);
-                _mm256_store_ps(mem + simd_width * 0x4, r4);
-                _mm256_store_ps(mem + simd_width * 0x5, r5);
-                _mm256_store_ps(mem + simd_width * 0x6, r6);
-                _mm256_store_ps(mem + simd_width * 0x7, r7);
-
-                break;
+                r0 = _mm256_fmadd_ps(r0, m, z);
+                r1 = _mm256_fmadd_ps(r1, m, z);
+                r2 = _mm256_fmadd_ps(r2, m, z);
+                r3 = _mm256_fmadd_ps(r3, m, z);
+                r4 = _mm256_fmadd_ps(r4, m, z);
+                r5 = _mm256_fmadd_ps(r5, m, z);
+                r6 = _mm256_fmadd_ps(r6, m, z);
+                r7 = _mm256_fmadd_ps(r7, m, z);
             }
-            case 2:
-            {
-                static const int batch = 4;
-                static const size_t simd_step1 = simd_width / sizeof(float);
-                static const size_t simd_step2 = simd_step1 * batch;
-
-                const float *vecA0 = vecA + simd_step1 * 0;
-                const float *vecA1 = vecA + simd_step1 * 1;
-                const float *vecA2 = vecA + simd_step1 * 2;
-                const float *vecA3 = vecA + simd_step1 * 3;
-
-                __m256 b0 = _mm256_setzero_ps();
-                __m256 b1 = _mm256_setzero_ps();
-                __m256 b2 = _mm256_setzero_ps();
-                __m256 b3 = _mm256_setzero_ps();
-
-                for (size_t i = 0; i < _length; i += simd_step2)
-                {
-                    const __m256 a0 = _mm256_load_ps(vecA0 + i);
-                    const __m256 a1 = _mm256_load_ps(vecA1 + i);
-                    const __m256 a2 = _mm256_load_ps(vecA2 + i);
-                    const __m256 a3 = _mm256_load_ps(vecA3 + i);
-
-                    b0 = _mm256_fmadd_ps(a0, a0, b0);
-                    b1 = _mm256_fmadd_ps(a1, a1, b1);
-                    b2 = _mm256_fmadd_ps(a2, a2, b2);
-                    b3 = _mm256_fmadd_ps(a3, a3, b3);
-                }
-
-                const __m256 b = _mm256_add_ps(_mm256_add_ps(b0, b1), _mm256_add_ps(b2, b3));
-                alignas(simd_width) float mem[simd_width];
-                _mm256_store_ps(mem, b);
 
-                break;
-            }
-            case 3:
-            {
-                static const size_t simd_step = simd_width / sizeof(float);
+            alignas(simd_width) float mem[simd_width * batch];
+            _mm256_store_ps(mem + simd_width * 0x0, r0);
+            _mm256_store_ps(mem + simd_width * 0x1, r1);
+            _mm256_store_ps(mem + simd_width * 0x2, r2);
+            _mm256_store_ps(mem + simd_width * 0x3, r3);
+            _mm256_store_ps(mem + simd_width * 0x4, r4);
+            _mm256_store_ps(mem + simd_width * 0x5, r5);
+            _mm256_store_ps(mem + simd_width * 0x6, r6);
+            _mm256_store_ps(mem + simd_width * 0x7, r7);
+            for (int k = 0; k < batch; ++k) consumeResult(mem + simd_width * k, simd_step1);
+
+            break;
+        }
+        case 2:
+        {
+            static const int batch = 4;
+            static const size_t simd_step1 = simd_width / sizeof(float);
+            static const size_t simd_step2 = simd_step1 * batch;
 
-                for (size_t i = 0; i < _length; i += simd_step)
-                {
-                    const __m256 a = _mm256_load_ps(vecA + i);
-                    const __m256 b = _mm256_fmadd_ps(a, a, a);
-                    _mm256_store_ps(vecB + i, b);
-                }
+            const float *vecA0 = vecA + simd_step1 * 0;
+            const float *vecA1 = vecA + simd_step1 * 1;
+            const float *vecA2 = vecA + simd_step1 * 2;
+            const float *vecA3 = vecA + simd_step1 * 3;
 
-                break;
+            __m256 b0 = _mm256_setzero_ps();
+            __m256 b1 = _mm256_setzero_ps();
+            __m256 b2 = _mm256_setzero_ps();
+            __m256 b3 = _mm256_setzero_ps();
+
+            for (size_t i = 0; i < _length; i += simd_step2)
+            {
+                const __m256 a0 = _mm256_load_ps(vecA0 + i);
+                const __m256 a1 = _mm256_load_ps(vecA1 + i);
+                const __m256 a2 = _mm256_load_ps(vecA2 + i);
+                const __m256 a3 = _mm256_load_ps(vecA3 + i);
+
+                b0 = _mm256_fmadd_ps(a0, a0, b0);
+                b1 = _mm256_fmadd_ps(a1, a1, b1);
+                b2 = _mm256_fmadd_ps(a2, a2, b2);
+                b3 = _mm256_fmadd_ps(a3, a3, b3);
             }
-            case 4:
+
+            const __m256 b = _mm256_add_ps(_mm256_add_ps(b0, b1), _mm256_add_ps(b2, b3));
+            alignas(simd_width) float mem[simd_width];
+            _mm256_store_ps(mem, b);
+            consumeResult(mem, simd_step1);
+
+            break;
+        }
+        case 3:
+        {
+            static const size_t simd_step = simd_width / sizeof(float);
+
+            for (size_t i = 0; i < _length; i += simd_step)
             {
-                const __m256i c0 = _mm256_setzero_si256();
-                const __m256i c1 = _mm256_set1_epi32(1);
-                const __m256i c2 = _mm256_set_epi32(1, 2, 4, 8, 16, 32, 64, 128);
-                const __m256i c3 = _mm256_set_epi32(128, 64, 32, 16, 8, 4, 2, 1);
-
-                __m256i r0 = c2;
-                __m256i r1 = c3;
-                __m256i r2, r3;
-
-                for (int j = 0; j < batch; ++j)
-                { // loop for batch
-                  // Arithmetic
-                    r2 = _mm256_add_epi32(r0, r1);
-                    r3 = _mm256_sub_epi32(r0, r1);
-                    r0 = _mm256_mul_epi32(r2, r3);
-                    // Special Math Functions
-                    r2 = _mm256_min_epi32(r0, r1);
-                    r3 = _mm256_max_epi32(r0, r1);
-                    // Swizzle
-                    r0 = _mm256_unpacklo_epi32(r2, r3);
-                    r1 = _mm256_unpackhi_epi32(r2, r3);
-                }
-
-                alignas(simd_width) int32_t mem[simd_width / 2];
-                _mm256_store_si256(reinterpret_cast<__m256i *>(mem), r0);
-                _mm256_store_si256(reinterpret_cast<__m256i *>(mem + simd_width / 4), r1);
+                const __m256 a = _mm256_load_ps(vecA + i);
+                const __m256 b = _mm256_fmadd_ps(a, a, a);
+                _mm256_store_ps(vecB + i, b);
+            }
 
-                break;
+            break;
+        }
+        case 4:
+        {
+            const __m256i c0 = _mm256_setzero_si256();
+            const __m256i c1 = _mm256_set1_epi32(1);
+            const __m256i c2 = _mm256_set_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+            const __m256i c3 = _mm256_set_epi32(128, 64, 32, 16, 8, 4, 2, 1);
+
+            __m256i r0 = c2;
+            __m256i r1 = c3;
+            __m256i r2, r3;
+
+            for (int j = 0; j < batch; ++j)
+            { // loop for batch
+              // Arithmetic
+                r2 = _mm256_add_epi32(r0, r1);
+                r3 = _mm256_sub_epi32(r0, r1);
+                r0 = _mm256_mul_epi32(r2, r3);
+                // Special Math Functions
+                r2 = _mm256_min_epi32(r0, r1);
+                r3 = _mm256_max_epi32(r0, r1);
+                // Swizzle
+                r0 = _mm256_unpacklo_epi32(r2, r3);
+                r1 = _mm256_unpackhi_epi32(r2, r3);
             }
-            case 5:
-            {
-                const __m256i c0 = _mm256_setzero_si256();
-                const __m256i c1 = _mm256_set1_epi32(1);
-                const __m256i c2 = _mm256_set_epi32(1, 2, 4, 8, 16, 32, 64, 128);
-                const __m256i c3 = _mm256_set_epi32(128, 64, 32, 16, 8, 4, 2, 1);
-
-                __m256i r0 = c2;
-                __m256i r1 = c3;
-                __m256i r2, r3;
-
-                for (int j = 0; j < batch; ++j)
-                { // loop for batch
-                  // Arithmetic
-                    r2 = _mm256_add_epi32(r0, r1);
-                    r3 = _mm256_sub_epi32(r0, r1);
-                    r0 = _mm256_hadd_epi32(r2, r3);
-                    r1 = _mm256_mul_epi32(r2, r3);
-                    // Logical
-                    r2 = _mm256_and_si256(r0, r1);
-                    r3 = _mm256_or_si256(r0, r1);
-                    r0 = _mm256_andnot_si256(r2, r3);
-                    r1 = _mm256_xor_si256(r2, r3);
-                    // Special Math Functions
-                    r2 = _mm256_min_epi32(r0, r1);
-                    r3 = _mm256_max_epi32(r0, r1);
-                    // Swizzle
-                    r2 = _mm256_unpackhi_epi32(r0, r1);
-                    r3 = _mm256_unpacklo_epi32(r0, r1);
-                    r0 = _mm256_unpacklo_epi32(r2, r3);
-                    r1 = _mm256_blend_epi32(r2, r3, 0x55);
-                }
-
-                alignas(simd_width) int32_t mem[simd_width / 2];
-                _mm256_store_si256(reinterpret_cast<__m256i *>(mem), r0);
-                _mm256_store_si256(reinterpret_cast<__m256i *>(mem + simd_width / 4), r1);
 
-                break;
+            alignas(simd_width) int32_t mem[simd_width / 2];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(mem), r0);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(mem + simd_width / 4), r1);
+            consume(mem, simd_width / 2);
+
+            break;
+        }
+        case 5:
+        {
+            const __m256i c0 = _mm256_setzero_si256();
+            const __m256i c1 = _mm256_set1_epi32(1);
+            const __m256i c2 = _mm256_set_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+            const __m256i c3 = _mm256_set_epi32(128, 64, 32, 16, 8, 4, 2, 1);
+
+            __m256i r0 = c2;
+            __m256i r1 = c3;
+            __m256i r2, r3;
+
+            for (int j = 0; j < batch; ++j)
+            { // loop for batch
+              // Arithmetic
+                r2 = _mm256_add_epi32(r0, r1);
+                r3 = _mm256_sub_epi32(r0, r1);
+                r0 = _mm256_hadd_epi32(r2, r3);
+                r1 = _mm256_mul_epi32(r2, r3);
+                // Logical
+                r2 = _mm256_and_si256(r0, r1);
+                r3 = _mm256_or_si256(r0, r1);
+                r0 = _mm256_andnot_si256(r2, r3);
+                r1 = _mm256_xor_si256(r2, r3);
+                // Special Math Functions
+                r2 = _mm256_min_epi32(r0, r1);
+                r3 = _mm256_max_epi32(r0, r1);
+                // Swizzle
+                r2 = _mm256_unpackhi_epi32(r0, r1);
+                r3 = _mm256_unpacklo_epi32(r0, r1);
+                r0 = _mm256_unpacklo_epi32(r2, r3);
+                r1 = _mm256_blend_epi32(r2, r3, 0x55);
             }
-            default:
-                if (!silent) std::cout << "type=" << type << " is not supported by this mode!";
-                break;
-            } while (stress_test); // infinite loop when doing stress test
+
+            alignas(simd_width) int32_t mem[simd_width / 2];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(mem), r0);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(mem + simd_width / 4), r1);
+            consume(mem, simd_width / 2);
+
+            break;
+        }
+        default:
+            if (!silent) std::cout << "type=" << type << " is not supported by this mode!";
+            break;
         }
     }
 };
@@ -527,132 +802,134 @@ public:
 protected:
     virtual size_t simdWidth() const override { return simd_width; }
 
-    virtual void kernel() const override
+    virtual void iterate() const override
     {
-#pragma omp parallel for
-        for (int l = 0; l < loop; ++l)
-        { // main loop
-            do switch (type)
-            {
-            case 1:
+        switch (type)
+        {
+        case 1:
+        {
+            static const int batch = 8;
+            static const size_t simd_step = simd_width * batch / sizeof(float);
+            static const size_t simd_step1 = simd_width / sizeof(float);
+            const __m512 m = _mm512_set1_ps(op_mul);
+            const __m512 z = _mm512_set1_ps(op_add);
+            __m512 r0 = _mm512_load_ps(vecOp + simd_step1 * 0);
+            __m512 r1 = _mm512_load_ps(vecOp + simd_step1 * 1);
+            __m512 r2 = _mm512_load_ps(vecOp + simd_step1 * 2);
+            __m512 r3 = _mm512_load_ps(vecOp + simd_step1 * 3);
+            __m512 r4 = _mm512_load_ps(vecOp + simd_step1 * 4);
+            __m512 r5 = _mm512_load_ps(vecOp + simd_step1 * 5);
+            __m512 r6 = _mm512_load_ps(vecOp + simd_step1 * 6);
+            __m512 r7 = _mm512_load_ps(vecOp + simd_step1 * 7);
+
+            for (size_t i = 0; i < _length; i += simd_step)
             {
-                static const int batch = 8;
-                static const size_t simd_step = simd_width * batch / sizeof(float);
-                __m512 r0 = _mm512_setzero_ps();
-                __m512 r1 = _mm512_setzero_ps();
-                __m512 r2 = _mm512_setzero_ps();
-                __m512 r3 = _mm512_setzero_ps();
-                __m512 r4 = _mm512_setzero_ps();
-                __m512 r5 = _mm512_setzero_ps();
-                __m512 r6 = _mm512_setzero_ps();
-                __m512 r7 = _mm512_setzero_ps();
-
-                for (size_t i = 0; i < _length; i += simd_step)
-                {
-                    r0 = _mm512_fmadd_ps(r0, r0, r0);
-                    r1 = _mm512_fmadd_ps(r1, r1, r1);
-                    r2 = _mm512_fmadd_ps(r2, r2, r2);
-                    r3 = _mm512_fmadd_ps(r3, r3, r3);
-                    r4 = _mm512_fmadd_ps(r4, r4, r4);
-                    r5 = _mm512_fmadd_ps(r5, r5, r5);
-                    r6 = _mm512_fmadd_ps(r6, r6, r6);
-                    r7 = _mm512_fmadd_ps(r7, r7, r7);
-                }
-
-                alignas(simd_width) float mem[simd_width * batch];
-                _mm512_store_ps(mem + simd_width * 0x0, r0);
-                _mm512_store_ps(mem + simd_width * 0x1, r1);
-                _mm512_store_ps(mem + simd_width * 0x2, r2);
-                _mm512_store_ps(mem + simd_width * 0x3, r3);
-                _mm512_store_ps(mem + simd_width * 0x4, r4);
-                _mm512_store_ps(mem + simd_width * 0x5, r5);
-                _mm512_store_ps(mem + simd_width * 0x6, r6);
-                _mm512_store_ps(mem + simd_width * 0x7, r7);
-
-                break;
+                r0 = _mm512_fmadd_ps(r0, m, z);
+                r1 = _mm512_fmadd_ps(r1, m, z);
+                r2 = _mm512_fmadd_ps(r2, m, z);
+                r3 = _mm512_fmadd_ps(r3, m, z);
+                r4 = _mm512_fmadd_ps(r4, m, z);
+                r5 = _mm512_fmadd_ps(r5, m, z);
+                r6 = _mm512_fmadd_ps(r6, m, z);
+                r7 = _mm512_fmadd_ps(r7, m, z);
             }
-            case 2:
-            {
-                static const int batch = 4;
-                static const size_t simd_step1 = simd_width / sizeof(float);
-                static const size_t simd_step2 = simd_step1 * batch;
-
-                const float *vecA0 = vecA + simd_step1 * 0;
-                const float *vecA1 = vecA + simd_step1 * 1;
-                const float *vecA2 = vecA + simd_step1 * 2;
-                const float *vecA3 = vecA + simd_step1 * 3;
-
-                __m512 b0 = _mm512_setzero_ps();
-                __m512 b1 = _mm512_setzero_ps();
-                __m512 b2 = _mm512_setzero_ps();
-                __m512 b3 = _mm512_setzero_ps();
-
-                for (size_t i = 0; i < _length; i += simd_step2)
-                {
-                    const __m512 a0 = _mm512_load_ps(vecA0 + i);
-                    const __m512 a1 = _mm512_load_ps(vecA1 + i);
-                    const __m512 a2 = _mm512_load_ps(vecA2 + i);
-                    const __m512 a3 = _mm512_load_ps(vecA3 + i);
-
-                    b0 = _mm512_fmadd_ps(a0, a0, b0);
-                    b1 = _mm512_fmadd_ps(a1, a1, b1);
-                    b2 = _mm512_fmadd_ps(a2, a2, b2);
-                    b3 = _mm512_fmadd_ps(a3, a3, b3);
-                }
-
-                const __m512 b = _mm512_add_ps(_mm512_add_ps(b0, b1), _mm512_add_ps(b2, b3));
-                alignas(simd_width) float mem[simd_width];
-                _mm512_store_ps(mem, b);
 
-                break;
-            }
-            case 3:
-            {
-                static const size_t simd_step = simd_width / sizeof(float);
+            alignas(simd_width) float mem[simd_width * batch];
+            _mm512_store_ps(mem + simd_width * 0x0, r0);
+            _mm512_store_ps(mem + simd_width * 0x1, r1);
+            _mm512_store_ps(mem + simd_width * 0x2, r2);
+            _mm512_store_ps(mem + simd_width * 0x3, r3);
+            _mm512_store_ps(mem + simd_width * 0x4, r4);
+            _mm512_store_ps(mem + simd_width * 0x5, r5);
+            _mm512_store_ps(mem + simd_width * 0x6, r6);
+            _mm512_store_ps(mem + simd_width * 0x7, r7);
+            for (int k = 0; k < batch; ++k) consumeResult(mem + simd_width * k, simd_step1);
 
-                for (size_t i = 0; i < _length; i += simd_step)
-                {
-                    const __m512 a = _mm512_load_ps(vecA + i);
-                    const __m512 b = _mm512_fmadd_ps(a, a, a);
-                    _mm512_store_ps(vecB + i, b);
-                }
+            break;
+        }
+        case 2:
+        {
+            static const int batch = 4;
+            static const size_t simd_step1 = simd_width / sizeof(float);
+            static const size_t simd_step2 = simd_step1 * batch;
 
-                break;
+            const float *vecA0 = vecA + simd_step1 * 0;
+            const float *vecA1 = vecA + simd_step1 * 1;
+            const float *vecA2 = vecA + simd_step1 * 2;
+            const float *vecA3 = vecA + simd_step1 * 3;
+
+            __m512 b0 = _mm512_setzero_ps();
+            __m512 b1 = _mm512_setzero_ps();
+            __m512 b2 = _mm512_setzero_ps();
+            __m512 b3 = _mm512_setzero_ps();
+
+            for (size_t i = 0; i < _length; i += simd_step2)
+            {
+                const __m512 a0 = _mm512_load_ps(vecA0 + i);
+                const __m512 a1 = _mm512_load_ps(vecA1 + i);
+                const __m512 a2 = _mm512_load_ps(vecA2 + i);
+                const __m512 a3 = _mm512_load_ps(vecA3 + i);
+
+                b0 = _mm512_fmadd_ps(a0, a0, b0);
+                b1 = _mm512_fmadd_ps(a1, a1, b1);
+                b2 = _mm512_fmadd_ps(a2, a2, b2);
+                b3 = _mm512_fmadd_ps(a3, a3, b3);
             }
-            case 4:
+
+            const __m512 b = _mm512_add_ps(_mm512_add_ps(b0, b1), _mm512_add_ps(b2, b3));
+            alignas(simd_width) float mem[simd_width];
+            _mm512_store_ps(mem, b);
+            consumeResult(mem, simd_step1);
+
+            break;
+        }
+        case 3:
+        {
+            static const size_t simd_step = simd_width / sizeof(float);
+
+            for (size_t i = 0; i < _length; i += simd_step)
             {
-                const __m512 c0 = _mm512_setzero_ps();
-                const __m512 c1 = _mm512_set1_ps(1);
-                const __m512 c2 = _mm512_set_ps(1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16184, 32768);
-                const __m512 c3 = _mm512_set_ps(32768, 16184, 8192, 4096, 2048, 1024, 512, 256, 128, 64, 32, 16, 8, 4, 2, 1);
-
-                __m512 r0 = c2;
-                __m512 r1 = c3;
-                __m512 r2, r3;
-
-                for (int j = 0; j < batch; ++j)
-                { // loop for batch
-                  // Arithmetic
-                    r2 = _mm512_add_ps(r0, r1);
-                    r3 = _mm512_sub_ps(r0, r1);
-                    r0 = _mm512_mul_ps(r2, r3);
-                    // Special Math Functions
-                    r2 = _mm512_min_ps(r0, r1);
-                    r3 = _mm512_max_ps(r0, r1);
-                    // Swizzle
-                    r0 = _mm512_shuffle_ps(r2, r3, 0xaa);
-                }
-
-                alignas(simd_width) float mem[simd_width / 2];
-                _mm512_store_ps(mem, r0);
-                _mm512_store_ps(mem + simd_width / 4, r1);
+                const __m512 a = _mm512_load_ps(vecA + i);
+                const __m512 b = _mm512_fmadd_ps(a, a, a);
+                _mm512_store_ps(vecB + i, b);
+            }
 
-                break;
+            break;
+        }
+        case 4:
+        {
+            const __m512 c0 = _mm512_setzero_ps();
+            const __m512 c1 = _mm512_set1_ps(1);
+            const __m512 c2 = _mm512_set_ps(1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16184, 32768);
+            const __m512 c3 = _mm512_set_ps(32768, 16184, 8192, 4096, 2048, 1024, 512, 256, 128, 64, 32, 16, 8, 4, 2, 1);
+
+            __m512 r0 = c2;
+            __m512 r1 = c3;
+            __m512 r2, r3;
+
+            for (int j = 0; j < batch; ++j)
+            { // loop for batch
+              // Arithmetic
+                r2 = _mm512_add_ps(r0, r1);
+                r3 = _mm512_sub_ps(r0, r1);
+                r0 = _mm512_mul_ps(r2, r3);
+                // Special Math Functions
+                r2 = _mm512_min_ps(r0, r1);
+                r3 = _mm512_max_ps(r0, r1);
+                // Swizzle
+                r0 = _mm512_shuffle_ps(r2, r3, 0xaa);
             }
-            default:
-                if (!silent) std::cout << "type=" << type << " is not supported by this mode!";
-                break;
-            } while (stress_test); // infinite loop when doing stress test
+
+            alignas(simd_width) float mem[simd_width / 2];
+            _mm512_store_ps(mem, r0);
+            _mm512_store_ps(mem + simd_width / 4, r1);
+            consume(mem, simd_width / 2);
+
+            break;
+        }
+        default:
+            if (!silent) std::cout << "type=" << type << " is not supported by this mode!";
+            break;
         }
     }
 };
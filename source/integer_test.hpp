@@ -0,0 +1,275 @@
+#pragma once
+
+#include "instruction_test.hpp"
+
+// Throughput and latency of 8/16-bit integer pixel operations
+class IntegerTest
+    : public InstructionTest
+{
+public:
+    int iterations = 0x100000; // of the unrolled loop in each measurement
+
+    static const int op_count = 8;
+
+    static const char *OpName(int op)
+    {
+        switch (op)
+        {
+        case 0: return "adds_epu8";
+        case 1: return "adds_epi16";
+        case 2: return "maddubs_epi16";
+        case 3: return "mulhrs_epi16";
+        case 4: return "packus_epi16";
+        case 5: return "srli_epi16";
+        case 6: return "slli_epi16";
+        case 7: return "shuffle_epi8";
+        default: return "none";
+        }
+    }
+
+    // bits of each lane of the result
+    static int LaneBits(int op)
+    {
+        switch (op)
+        {
+        case 0:
+        case 4:
+        case 7:
+            return 8;
+        default:
+            return 16;
+        }
+    }
+
+    virtual void RunTest() override
+    {
+        const int threads_new = beginTest();
+
+        times = 0;
+        results.clear();
+
+        while (repeat <= 0 || times < repeat)
+        { // infinite loop for continuous tests
+            ++times;
+
+            if (!silent)
+            {
+                std::cout << times << ": " << isaName() << " integer operations, throughput on " << threads_new << " threads.\n"
+                    << "    operation        lanes    throughput (Gops/s)    instructions (G/s)    latency (ns)\n";
+            }
+
+            for (int op = 0; op < op_count; ++op)
+            {
+                const int lanes = static_cast<int>(simdWidth()) * 8 / LaneBits(op);
+                const double instructions = static_cast<double>(iterations) * unroll;
+
+                // throughput: independent chains on all the threads
+                MyClock::time_point t1 = MyClock::now();
+#pragma omp parallel
+                {
+                    const unsigned int csr = SetFlushDenormals(ftz_daz);
+                    run(op, false);
+                    _mm_setcsr(csr);
+                }
+                MySeconds time_span = std::chrono::duration_cast<MySeconds>(MyClock::now() - t1);
+                const double ginst = instructions * threads_new / (time_span.count() * 1e9);
+
+                // latency: a single chain
+                const double ns = run(op, true) * 1e9 / instructions;
+
+                if (!silent)
+                {
+                    const std::string lane_name = std::to_string(lanes) + "x" + std::to_string(LaneBits(op));
+                    std::cout << "    " << std::left << std::setw(16) << OpName(op) << std::setw(6) << lane_name << std::right
+                        << std::setprecision(2) << std::setw(22) << ginst * lanes
+                        << std::setw(22) << ginst
+                        << std::setprecision(3) << std::setw(16) << ns << "\n";
+                }
+            }
+        }
+
+        endTest();
+    }
+
+protected:
+    static const int unroll = 12; // independent chains, enough for 2 ports of 5-cycle latency
+
+    virtual const char *isaName() const = 0;
+
+    // seconds of the operation, as 12 independent chains or as a single chain
+    virtual double run(int op, bool chain) const = 0;
+
+    virtual void kernel() const override {}
+
+    // a vector of bytes unknown to the compiler
+    template < typename _Ty >
+    static _Ty Opaque(int salt)
+    {
+        volatile int32_t seed = 0x01020304;
+        int32_t words[sizeof(_Ty) / sizeof(int32_t)];
+        for (size_t i = 0; i < sizeof(_Ty) / sizeof(int32_t); ++i) words[i] = seed * static_cast<int32_t>(i + salt);
+        _Ty v;
+        std::memcpy(&v, words, sizeof(v));
+        return v;
+    }
+
+    template < typename _Ty, typename _Op >
+    FLATTEN double measure(_Op op, bool chain) const
+    {
+        const _Ty c = Opaque<_Ty>(unroll + 1);
+        _Ty r0 = Opaque<_Ty>(0), r1 = Opaque<_Ty>(1), r2 = Opaque<_Ty>(2), r3 = Opaque<_Ty>(3);
+        _Ty r4 = Opaque<_Ty>(4), r5 = Opaque<_Ty>(5), r6 = Opaque<_Ty>(6), r7 = Opaque<_Ty>(7);
+        _Ty r8 = Opaque<_Ty>(8), r9 = Opaque<_Ty>(9), r10 = Opaque<_Ty>(10), r11 = Opaque<_Ty>(11);
+
+        MyClock::time_point t1 = MyClock::now();
+
+        if (chain)
+        {
+            for (int i = 0; i < iterations; ++i)
+            {
+                r0 = op(r0, c); OPAQUE(r0); r0 = op(r0, c); OPAQUE(r0);
+                r0 = op(r0, c); OPAQUE(r0); r0 = op(r0, c); OPAQUE(r0);
+                r0 = op(r0, c); OPAQUE(r0); r0 = op(r0, c); OPAQUE(r0);
+                r0 = op(r0, c); OPAQUE(r0); r0 = op(r0, c); OPAQUE(r0);
+                r0 = op(r0, c); OPAQUE(r0); r0 = op(r0, c); OPAQUE(r0);
+                r0 = op(r0, c); OPAQUE(r0); r0 = op(r0, c); OPAQUE(r0);
+            }
+        }
+        else
+        {
+            for (int i = 0; i < iterations; ++i)
+            {
+                r0 = op(r0, c); OPAQUE(r0); r1 = op(r1, c); OPAQUE(r1);
+                r2 = op(r2, c); OPAQUE(r2); r3 = op(r3, c); OPAQUE(r3);
+                r4 = op(r4, c); OPAQUE(r4); r5 = op(r5, c); OPAQUE(r5);
+                r6 = op(r6, c); OPAQUE(r6); r7 = op(r7, c); OPAQUE(r7);
+                r8 = op(r8, c); OPAQUE(r8); r9 = op(r9, c); OPAQUE(r9);
+                r10 = op(r10, c); OPAQUE(r10); r11 = op(r11, c); OPAQUE(r11);
+            }
+        }
+
+        MySeconds time_span = std::chrono::duration_cast<MySeconds>(MyClock::now() - t1);
+
+        static const size_t words = unroll * sizeof(_Ty) / sizeof(int32_t);
+        const _Ty r[unroll] = { r0, r1, r2, r3, r4, r5, r6, r7, r8, r9, r10, r11 };
+        int32_t mem[words];
+        std::memcpy(mem, r, sizeof(mem));
+        consume(mem, words);
+
+        return time_span.count();
+    }
+};
+
+
+class SSE41IntegerTest
+    : public IntegerTest
+{
+public:
+    static const size_t simd_width = 16;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual const char *isaName() const override { return "128-bit SSE4.1"; }
+
+    virtual double run(int op, bool chain) const override
+    {
+        switch (op)
+        {
+        case 0:
+            return measure<__m128i>([](__m128i a, __m128i b) { return _mm_adds_epu8(a, b); }, chain);
+        case 1:
+            return measure<__m128i>([](__m128i a, __m128i b) { return _mm_adds_epi16(a, b); }, chain);
+        case 2:
+            return measure<__m128i>([](__m128i a, __m128i b) { return _mm_maddubs_epi16(a, b); }, chain);
+        case 3:
+            return measure<__m128i>([](__m128i a, __m128i b) { return _mm_mulhrs_epi16(a, b); }, chain);
+        case 4:
+            return measure<__m128i>([](__m128i a, __m128i b) { return _mm_packus_epi16(a, b); }, chain);
+        case 5:
+            return measure<__m128i>([](__m128i a, __m128i) { return _mm_srli_epi16(a, 1); }, chain);
+        case 6:
+            return measure<__m128i>([](__m128i a, __m128i) { return _mm_slli_epi16(a, 1); }, chain);
+        case 7:
+            return measure<__m128i>([](__m128i a, __m128i b) { return _mm_shuffle_epi8(a, b); }, chain);
+        default:
+            return 0;
+        }
+    }
+};
+
+
+class AVX2IntegerTest
+    : public IntegerTest
+{
+public:
+    static const size_t simd_width = 32;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual const char *isaName() const override { return "256-bit AVX2"; }
+
+    virtual double run(int op, bool chain) const override
+    {
+        switch (op)
+        {
+        case 0:
+            return measure<__m256i>([](__m256i a, __m256i b) { return _mm256_adds_epu8(a, b); }, chain);
+        case 1:
+            return measure<__m256i>([](__m256i a, __m256i b) { return _mm256_adds_epi16(a, b); }, chain);
+        case 2:
+            return measure<__m256i>([](__m256i a, __m256i b) { return _mm256_maddubs_epi16(a, b); }, chain);
+        case 3:
+            return measure<__m256i>([](__m256i a, __m256i b) { return _mm256_mulhrs_epi16(a, b); }, chain);
+        case 4:
+            return measure<__m256i>([](__m256i a, __m256i b) { return _mm256_packus_epi16(a, b); }, chain);
+        case 5:
+            return measure<__m256i>([](__m256i a, __m256i) { return _mm256_srli_epi16(a, 1); }, chain);
+        case 6:
+            return measure<__m256i>([](__m256i a, __m256i) { return _mm256_slli_epi16(a, 1); }, chain);
+        case 7:
+            return measure<__m256i>([](__m256i a, __m256i b) { return _mm256_shuffle_epi8(a, b); }, chain);
+        default:
+            return 0;
+        }
+    }
+};
+
+
+class AVX512BWIntegerTest
+    : public IntegerTest
+{
+public:
+    static const size_t simd_width = 64;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual const char *isaName() const override { return "512-bit AVX-512BW"; }
+
+    virtual double run(int op, bool chain) const override
+    {
+        switch (op)
+        {
+        case 0:
+            return measure<__m512i>([](__m512i a, __m512i b) { return _mm512_adds_epu8(a, b); }, chain);
+        case 1:
+            return measure<__m512i>([](__m512i a, __m512i b) { return _mm512_adds_epi16(a, b); }, chain);
+        case 2:
+            return measure<__m512i>([](__m512i a, __m512i b) { return _mm512_maddubs_epi16(a, b); }, chain);
+        case 3:
+            return measure<__m512i>([](__m512i a, __m512i b) { return _mm512_mulhrs_epi16(a, b); }, chain);
+        case 4:
+            return measure<__m512i>([](__m512i a, __m512i b) { return _mm512_packus_epi16(a, b); }, chain);
+        case 5:
+            return measure<__m512i>([](__m512i a, __m512i) { return _mm512_srli_epi16(a, 1); }, chain);
+        case 6:
+            return measure<__m512i>([](__m512i a, __m512i) { return _mm512_slli_epi16(a, 1); }, chain);
+        case 7:
+            return measure<__m512i>([](__m512i a, __m512i b) { return _mm512_shuffle_epi8(a, b); }, chain);
+        default:
+            return 0;
+        }
+    }
+};
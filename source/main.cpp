@@ -1,9 +1,454 @@
 #include "instruction_test.hpp"
+#include "math_test.hpp"
+#include "gemm_test.hpp"
+#include "copy_test.hpp"
+#include "transition_test.hpp"
+#include "plane_test.hpp"
+#include "integer_test.hpp"
+#include "split_test.hpp"
+#include "result_store.hpp"
+#include "burn_in_daemon.hpp"
+#include "process_launcher.hpp"
 #include <memory>
 
+// Create the test of the chosen mode and type
+static std::shared_ptr<InstructionTest> CreateTest(int mode, int type)
+{
+    switch (type)
+    {
+    case 6:
+        switch (mode)
+        {
+        case 1:
+            return std::make_shared<AVXMathTest>();
+        case 2:
+            return std::make_shared<AVX2MathTest>();
+        case 3:
+            return std::make_shared<AVX512FMathTest>();
+        default:
+            return nullptr;
+        }
+    case 7:
+        switch (mode)
+        {
+        case 1:
+            return std::make_shared<AVXGemmTest>();
+        case 2:
+            return std::make_shared<AVX2GemmTest>();
+        case 3:
+            return std::make_shared<AVX512FGemmTest>();
+        default:
+            return nullptr;
+        }
+    case 8:
+        switch (mode)
+        {
+        case 1:
+        case 2:
+            return std::make_shared<AVXCopyTest>(); // AVX2 adds nothing to copying bytes
+        case 3:
+            return std::make_shared<AVX512FCopyTest>();
+        default:
+            return nullptr;
+        }
+    case 9:
+        switch (mode)
+        {
+        case 1:
+            return std::make_shared<AVXTransitionTest>();
+        case 2:
+            return std::make_shared<AVX2TransitionTest>();
+        case 3:
+            return std::make_shared<AVX512FTransitionTest>();
+        default:
+            return nullptr;
+        }
+    case 10:
+        switch (mode)
+        {
+        case 1:
+            return std::make_shared<AVXPlaneTest>();
+        case 2:
+            return std::make_shared<AVX2PlaneTest>();
+        case 3:
+            return std::make_shared<AVX512FPlaneTest>();
+        default:
+            return nullptr;
+        }
+    case 11:
+        switch (mode)
+        {
+        case 1:
+            return std::make_shared<SSE41IntegerTest>(); // AVX has no 256-bit integer operations
+        case 2:
+            return std::make_shared<AVX2IntegerTest>();
+        case 3:
+            return std::make_shared<AVX512BWIntegerTest>();
+        default:
+            return nullptr;
+        }
+    case 12:
+        switch (mode)
+        {
+        case 1:
+        case 2:
+            return std::make_shared<AVXSplitTest>(); // AVX2 adds nothing to loads and stores
+        case 3:
+            return std::make_shared<AVX512FSplitTest>();
+        default:
+            return nullptr;
+        }
+    default:
+        switch (mode)
+        {
+        case 1:
+            return std::make_shared<AVXTest>();
+        case 2:
+            return std::make_shared<AVX2Test>();
+        case 3:
+            return std::make_shared<AVX512FTest>();
+        default:
+            return nullptr;
+        }
+    }
+}
+
+// Command line options
+struct Options
+{
+    std::string command;
+    int mode = 3;
+    int type = 1;
+    int threads = 0;
+    int loop = 0x200;
+    int repeat = 8;
+    int operand = 1;
+    int denormal_ratio = 50;
+    int ftz_daz = 0;
+    std::string store = "mybench_results.tsv";
+    std::string against = "host";
+    double threshold = 5; // percent
+    double alpha = 0.05;
+    bool save = false;
+    std::string kernels; // daemon: mode:type list, all the types of --mode if empty
+    double period = 60;
+    double window = 60;
+    double interval = 15;
+    double duration = 0;
+    std::string textfile = "mybench.prom";
+    std::string processes; // scale: numbers of processes, powers of 2 if empty
+    int cpus_per_process = 1;
+    bool loop_set = false;
+};
+
+static void PrintUsage()
+{
+    std::cout <<
+        "Usage: MYBenchmark [command] [options]\n"
+        "    Without any argument, the benchmark is configured interactively.\n"
+        "\n"
+        "Commands:\n"
+        "    save                  run the benchmark and append the results to the store\n"
+        "    compare               run the benchmark and compare the results against a baseline,\n"
+        "                          exit with code 1 on a significant regression beyond the threshold\n"
+        "    daemon                burn-in: cycle through the kernels on every thread until stopped,\n"
+        "                          and export rolling-window metrics to a node-exporter textfile\n"
+        "    scale                 run type 1-3 in forked processes with separate CPU sets,\n"
+        "                          and report the scaling over the number of processes (not on Windows)\n"
+        "\n"
+        "Options:\n"
+        "    --mode N              1: AVX, 2: AVX2+FMA, 3: AVX-512F (default 3)\n"
+        "    --type N              test type 1-5 (default 1)\n"
+        "    --threads N           number of threads, 0 for all the processors (default 0)\n"
+        "    --loop N              number of loops (default 512 per processor)\n"
+        "    --repeat N            number of repeats (default 8)\n"
+        "    --operand N           operand values, 1: normal, 2: denormal, 3: mixed, 4: NaN/Inf, 5: zero (default 1)\n"
+        "    --denormal-ratio N    percentage of denormals in mixed operands (default 50)\n"
+        "    --ftz-daz N           MXCSR flush-to-zero/denormals-are-zero, 0: off, 1: on (default 0)\n"
+        "    --store FILE          results store (default mybench_results.tsv)\n"
+        "    --against host|fleet  compare against the latest run of this host,\n"
+        "                          or the other hosts with the same CPU model (default host)\n"
+        "    --threshold PCT       regression threshold in percent (default 5)\n"
+        "    --alpha P             significance level of the regression (default 0.05)\n"
+        "    --save                also append the results of \"compare\" to the store\n"
+        "\n"
+        "Daemon options (with --threads, --operand, --denormal-ratio and --ftz-daz):\n"
+        "    --kernels LIST        kernels as mode:type separated by commas, such as 3:1,3:3\n"
+        "                          (default all the types 1-5 of --mode)\n"
+        "    --period SEC          seconds of each kernel before switching to the next one (default 60)\n"
+        "    --window SEC          seconds of the rolling window (default 60)\n"
+        "    --interval SEC        seconds between the textfile updates (default 15)\n"
+        "    --duration SEC        seconds to run, 0 until interrupted (default 0)\n"
+        "    --textfile FILE       metrics file, rewritten atomically (default mybench.prom)\n"
+        "\n"
+        "Scale options (with --mode, --type, --loop, --repeat, --operand, --denormal-ratio and --ftz-daz):\n"
+        "    --processes LIST      numbers of processes separated by commas (default powers of 2 up to the CPUs)\n"
+        "                          1 process always runs first, as the reference of the efficiency\n"
+        "    --cpus-per-process N  CPUs and threads of each process (default 1)\n"
+        "    --loop N              loops of each process (default 512 per CPU)\n";
+}
+
+static bool ParseOptions(int argc, char **argv, Options &opt)
+{
+#ifdef _OPENMP
+    opt.loop *= omp_get_max_threads();
+#endif
+
+    if (argc < 2) return false;
+    opt.command = argv[1];
+    if (opt.command != "save" && opt.command != "compare" && opt.command != "daemon" && opt.command != "scale") return false;
+
+    for (int i = 2; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--save")
+        {
+            opt.save = true;
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        const std::string value = argv[++i];
+
+        try
+        {
+            if (arg == "--mode") opt.mode = std::stoi(value);
+            else if (arg == "--type") opt.type = std::stoi(value);
+            else if (arg == "--threads") opt.threads = std::stoi(value);
+            else if (arg == "--loop")
+            {
+                opt.loop = std::stoi(value);
+                opt.loop_set = true;
+            }
+            else if (arg == "--repeat") opt.repeat = std::stoi(value);
+            else if (arg == "--operand") opt.operand = std::stoi(value);
+            else if (arg == "--denormal-ratio") opt.denormal_ratio = std::stoi(value);
+            else if (arg == "--ftz-daz") opt.ftz_daz = std::stoi(value);
+            else if (arg == "--store") opt.store = value;
+            else if (arg == "--against") opt.against = value;
+            else if (arg == "--threshold") opt.threshold = std::stod(value);
+            else if (arg == "--alpha") opt.alpha = std::stod(value);
+            else if (arg == "--kernels") opt.kernels = value;
+            else if (arg == "--period") opt.period = std::stod(value);
+            else if (arg == "--window") opt.window = std::stod(value);
+            else if (arg == "--interval") opt.interval = std::stod(value);
+            else if (arg == "--duration") opt.duration = std::stod(value);
+            else if (arg == "--textfile") opt.textfile = value;
+            else if (arg == "--processes") opt.processes = value;
+            else if (arg == "--cpus-per-process") opt.cpus_per_process = std::stoi(value);
+            else return false;
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+    }
+
+    return opt.mode >= 1 && opt.mode <= 3 && opt.type >= 1 && opt.type <= 5
+        && opt.loop > 0 && opt.repeat > 0 && opt.operand >= 1 && opt.operand <= 5
+        && opt.denormal_ratio >= 0 && opt.denormal_ratio <= 100 && opt.ftz_daz >= 0 && opt.ftz_daz <= 1
+        && (opt.against == "host" || opt.against == "fleet")
+        && opt.period > 0 && opt.window > 0 && opt.interval > 0 && opt.duration >= 0
+        && opt.cpus_per_process > 0;
+}
+
+// Parse the daemon kernels such as "3:1,3:3"
+static bool ParseKernels(const Options &opt, std::vector<BurnInDaemon::Kernel> &kernels)
+{
+    kernels.clear();
+
+    if (opt.kernels.empty())
+    {
+        for (int type = 1; type <= (opt.mode == 3 ? 4 : 5); ++type) kernels.push_back({ opt.mode, type });
+        return true;
+    }
+
+    std::istringstream list(opt.kernels);
+    std::string item;
+    while (std::getline(list, item, ','))
+    {
+        const size_t colon = item.find(':');
+        if (colon == std::string::npos) return false;
+
+        BurnInDaemon::Kernel kernel;
+        try
+        {
+            kernel.mode = std::stoi(item.substr(0, colon));
+            kernel.type = std::stoi(item.substr(colon + 1));
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+
+        // AVX-512F has no type 5
+        if (kernel.mode < 1 || kernel.mode > 3 || kernel.type < 1 || kernel.type > (kernel.mode == 3 ? 4 : 5)) return false;
+        kernels.push_back(kernel);
+    }
+
+    return !kernels.empty();
+}
+
+// Run the burn-in daemon of the command line
+static int RunDaemon(const Options &opt, const std::vector<BurnInDaemon::Kernel> &kernels)
+{
+    BurnInDaemon daemon(CreateTest);
+    daemon.kernels = kernels;
+    daemon.threads = opt.threads;
+    daemon.operand = opt.operand;
+    daemon.denormal_ratio = opt.denormal_ratio;
+    daemon.ftz_daz = opt.ftz_daz != 0;
+    daemon.period = opt.period;
+    daemon.window = opt.window;
+    daemon.interval = opt.interval;
+    daemon.duration = opt.duration;
+    daemon.textfile = opt.textfile;
+    return daemon.Run();
+}
+
+// Run the benchmark of the command line, "save" or "compare" the results
+static int RunCommand(const Options &opt)
+{
+    std::shared_ptr<InstructionTest> instT = CreateTest(opt.mode, opt.type);
+    instT->silent = true;
+    instT->threads = opt.threads;
+    instT->loop = opt.loop;
+    instT->repeat = opt.repeat;
+    instT->type = opt.type;
+    instT->operand = opt.operand;
+    instT->denormal_ratio = opt.denormal_ratio;
+    instT->ftz_daz = opt.ftz_daz != 0;
+    instT->RunTest();
+
+    const std::string unit = opt.type <= 3 ? " GFLOPS" : " microseconds per loop";
+    const ResultRecord current = ResultRecord::Current("mode=" + std::to_string(opt.mode) + " " + instT->Parameters(), instT->results);
+    const ResultStore store(opt.store);
+    int code = 0;
+
+    std::cout << std::fixed << std::setprecision(3)
+        << "Host: " << current.host << " (" << current.cpu << ", " << current.system << ")\n"
+        << "Parameters: " << current.key << "\n"
+        << "Result: " << instT->MedianScore() << unit
+        << " (median of " << current.samples.size() << " repeats)\n";
+
+    if (opt.command == "compare")
+    {
+        std::vector<double> baseline;
+        std::string description;
+
+        if (opt.against == "host")
+        {
+            ResultRecord record;
+            if (store.HostBaseline(current, record))
+            {
+                baseline = record.samples;
+                description = "this host at " + record.time + " (" + record.system + ")";
+            }
+        }
+        else
+        {
+            const std::vector<ResultRecord> records = store.FleetBaseline(current);
+            std::vector<double> medians;
+            for (const ResultRecord &record : records)
+            {
+                baseline.insert(baseline.end(), record.samples.begin(), record.samples.end());
+                medians.push_back(Median(record.samples));
+            }
+            // the fleet baseline is the median of the per-host medians, the pooled samples are used for the test
+            if (!records.empty())
+            {
+                description = "fleet median of " + std::to_string(records.size()) + " hosts";
+                const double shift = Median(medians) / Median(baseline);
+                for (double &v : baseline) v *= shift;
+            }
+        }
+
+        if (baseline.empty())
+        {
+            std::cout << "No baseline found in \"" << opt.store << "\", nothing to compare.\n";
+        }
+        else
+        {
+            // compare the elapsed time, where higher means slower
+            const double change = Median(current.samples) / Median(baseline) - 1;
+            const double p = MannWhitneyTest(current.samples, baseline);
+            const bool regression = change * 100 > opt.threshold && p < opt.alpha;
+            code = regression ? 1 : 0;
+
+            std::cout << "Baseline: " << instT->Score(Median(baseline)) << unit << ", " << description << "\n"
+                << "Elapsed time change: " << std::showpos << change * 100 << std::noshowpos << "%"
+                << " (p=" << std::setprecision(4) << p << ", threshold " << std::setprecision(1) << opt.threshold
+                << "%, alpha " << std::setprecision(3) << opt.alpha << ")\n"
+                << (regression ? "REGRESSION" : "OK") << "\n";
+        }
+    }
+
+    if (opt.command == "save" || opt.save)
+    {
+        if (store.Append(current)) std::cout << "Results saved to \"" << opt.store << "\".\n";
+        else
+        {
+            std::cout << "Failed to save the results to \"" << opt.store << "\"!\n";
+            code = 2;
+        }
+    }
+
+    return code;
+}
+
+// Run the multi-process scaling of the command line
+static int RunScale(const Options &opt)
+{
+    ProcessLauncher launcher(CreateTest);
+    launcher.mode = opt.mode;
+    launcher.type = opt.type;
+    launcher.cpus_per_process = opt.cpus_per_process;
+    launcher.loop = opt.loop_set ? opt.loop : 0;
+    launcher.repeat = opt.repeat;
+    launcher.operand = opt.operand;
+    launcher.denormal_ratio = opt.denormal_ratio;
+    launcher.ftz_daz = opt.ftz_daz != 0;
+
+    std::istringstream list(opt.processes);
+    std::string item;
+    while (std::getline(list, item, ','))
+    {
+        try
+        {
+            launcher.counts.push_back(std::stoi(item));
+        }
+        catch (const std::exception &)
+        {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    return launcher.Run();
+}
+
 // Main
 int main(int argc, char **argv)
 {
+    // Command line mode
+    if (argc > 1)
+    {
+        Options opt;
+        std::vector<BurnInDaemon::Kernel> kernels;
+        if (!ParseOptions(argc, argv, opt) || (opt.command == "daemon" && !ParseKernels(opt, kernels)))
+        {
+            PrintUsage();
+            return 2;
+        }
+        if (opt.command == "scale" && opt.type > 3)
+        {
+            PrintUsage();
+            return 2;
+        }
+        if (opt.command == "daemon") return RunDaemon(opt, kernels);
+        if (opt.command == "scale") return RunScale(opt);
+        return RunCommand(opt);
+    }
+
     std::string input;
 
     // Set thread number
@@ -88,6 +533,13 @@ int main(int argc, char **argv)
         "    3: FMA test (with memory read+write stress)\n"
         "    4: Mixed test 1\n"
         "    5: Mixed test 2\n"
+        "    6: Math functions test (throughput, latency and accuracy)\n"
+        "    7: SGEMM micro-kernel test (fraction of the FMA peak)\n"
+        "    8: Memory copy/fill test (memcpy/memset engines over sizes and alignments)\n"
+        "    9: Clock transition test (scalar code around a vector burst, and on the SMT sibling)\n"
+        "    10: 2D plane test (FIR passes and transpose over padded row strides)\n"
+        "    11: 8/16-bit integer test (SSE4.1, AVX2 or AVX-512BW by mode)\n"
+        "    12: Split access test (unaligned, line-split and page-split loads/stores, store forwarding)\n"
         "    Leaving it blank implies the default setting.\n";
 
     while (true)
@@ -97,34 +549,287 @@ int main(int argc, char **argv)
         if (input == "") break;
         else type = std::stoi(input);
 
-        if (type < 1 || type > 5) std::cout << "Invalid input! Try again.\n";
+        if (type < 1 || type > 12) std::cout << "Invalid input! Try again.\n";
         else break;
     }
 
     std::cout << std::endl;
 
-    // Benchmark
-    std::shared_ptr<InstructionTest> instT = nullptr;
-
-    switch (mode)
-    {
-    case 1:
-        instT = std::make_shared<AVXTest>();
-        break;
-    case 2:
-        instT = std::make_shared<AVX2Test>();
-        break;
-    case 3:
-        instT = std::make_shared<AVX512FTest>();
-        break;
-    default:
-        break;
+    // Choose operand values
+    int operand = 1;
+
+    if (type >= 1 && type <= 3)
+    {
+        std::cout <<
+            "Choose operand values - default " + std::to_string(operand) + ".\n"
+            "    0: all of the following (not available for stress test)\n"
+            "    1: normal\n"
+            "    2: denormal\n"
+            "    3: mixed normal/denormal\n"
+            "    4: NaN/Inf\n"
+            "    5: zero\n"
+            "    Leaving it blank implies the default setting.\n";
+
+        while (true)
+        {
+            std::cout << "Your option: ";
+            std::getline(std::cin, input);
+            if (input == "") break;
+            else operand = std::stoi(input);
+
+            if (operand < 0 || operand > 5 || (operand == 0 && loop == 0)) std::cout << "Invalid input! Try again.\n";
+            else break;
+        }
+
+        std::cout << std::endl;
     }
 
+    // Set denormal ratio
+    int denormal_ratio = 50;
+
+    if (operand == 0 || operand == 3)
+    {
+        std::cout <<
+            "Set the percentage of denormals in mixed operands - default " + std::to_string(denormal_ratio) + ".\n"
+            "    Leaving it blank implies the default setting.\n";
+
+        while (true)
+        {
+            std::cout << "Your option: ";
+            std::getline(std::cin, input);
+            if (input == "") break;
+            else denormal_ratio = std::stoi(input);
+
+            if (denormal_ratio < 0 || denormal_ratio > 100) std::cout << "Invalid input! Try again.\n";
+            else break;
+        }
+
+        std::cout << std::endl;
+    }
+
+    // Choose FTZ/DAZ
+    int ftz_daz = 0;
+
+    std::cout <<
+        "Choose MXCSR flush-to-zero/denormals-are-zero mode - default " + std::to_string(ftz_daz) + ".\n"
+        "    0: off\n"
+        "    1: on\n"
+        "    2: both (only for type 1-5, not available for stress test)\n"
+        "    Leaving it blank implies the default setting.\n";
+
+    while (true)
+    {
+        std::cout << "Your option: ";
+        std::getline(std::cin, input);
+        if (input == "") break;
+        else ftz_daz = std::stoi(input);
+
+        if (ftz_daz < 0 || ftz_daz > 2 || (ftz_daz == 2 && (loop == 0 || type > 5))) std::cout << "Invalid input! Try again.\n";
+        else break;
+    }
+
+    std::cout << std::endl;
+
+    // Set SGEMM register tile
+    int tile_vectors = 2;
+    int tile_columns = mode == 3 ? 12 : 6;
+    int unroll = 4;
+
+    if (type == 7)
+    {
+        std::cout <<
+            "Set the register tile of the SGEMM micro-kernel as <vectors>x<columns> - default "
+            + std::to_string(tile_vectors) + "x" + std::to_string(tile_columns) + ".\n"
+            "    AVX and AVX2+FMA support 1x8, 2x4, 2x6 and 3x4.\n"
+            "    AVX-512F supports 1x8, 2x6, 2x12, 3x8 and 4x6.\n"
+            "    Leaving it blank implies the default setting.\n";
+
+        // a test of the mode, to check the tile against its micro-kernels
+        const std::shared_ptr<GemmTest> gemm_check = std::static_pointer_cast<GemmTest>(CreateTest(mode, type));
+
+        while (true)
+        {
+            std::cout << "Your option: ";
+            std::getline(std::cin, input);
+            if (input == "") break;
+            const size_t x = input.find('x');
+            if (x != std::string::npos)
+            {
+                tile_vectors = std::stoi(input.substr(0, x));
+                tile_columns = std::stoi(input.substr(x + 1));
+                gemm_check->tile_vectors = tile_vectors;
+                gemm_check->tile_columns = tile_columns;
+            }
+
+            if (x == std::string::npos || !gemm_check->SupportsTile()) std::cout << "Invalid input! Try again.\n";
+            else break;
+        }
+
+        std::cout << std::endl;
+
+        std::cout <<
+            "Set the unrolling of the K loop (1, 2, 4 or 8) - default " + std::to_string(unroll) + ".\n"
+            "    Leaving it blank implies the default setting.\n";
+
+        while (true)
+        {
+            std::cout << "Your option: ";
+            std::getline(std::cin, input);
+            if (input == "") break;
+            else unroll = std::stoi(input);
+
+            if (unroll != 1 && unroll != 2 && unroll != 4 && unroll != 8) std::cout << "Invalid input! Try again.\n";
+            else break;
+        }
+
+        std::cout << std::endl;
+    }
+
+    // Set the largest copy size
+    int copy_max_mib = 1024;
+
+    if (type == 8)
+    {
+        std::cout <<
+            "Set the largest size of copy/fill in MiB (a power of 2) - default " + std::to_string(copy_max_mib) + ".\n"
+            "    Twice the size is allocated.\n"
+            "    Leaving it blank implies the default setting.\n";
+
+        while (true)
+        {
+            std::cout << "Your option: ";
+            std::getline(std::cin, input);
+            if (input == "") break;
+            else copy_max_mib = std::stoi(input);
+
+            if (copy_max_mib < 1 || (copy_max_mib & (copy_max_mib - 1))) std::cout << "Invalid input! Try again.\n";
+            else break;
+        }
+
+        std::cout << std::endl;
+    }
+
+    // Set the length of the vector burst
+    int burst_us = 200;
+
+    if (type == 9)
+    {
+        std::cout <<
+            "Set the length of the vector burst in microseconds - default " + std::to_string(burst_us) + ".\n"
+            "    Leaving it blank implies the default setting.\n";
+
+        while (true)
+        {
+            std::cout << "Your option: ";
+            std::getline(std::cin, input);
+            if (input == "") break;
+            else burst_us = std::stoi(input);
+
+            if (burst_us < 1) std::cout << "Invalid input! Try again.\n";
+            else break;
+        }
+
+        std::cout << std::endl;
+    }
+
+    // Set repeat times
+    const bool combined = operand == 0 || ftz_daz == 2;
+    int repeat = combined ? 4 : 0;
+
+    if (loop > 0)
+    {
+        std::cout <<
+            "Set the number of repeats for each test - default " + std::to_string(repeat) + ".\n"
+            "    Use 0 for infinite repeats (not available for multiple combinations).\n"
+            "    Leaving it blank implies the default setting.\n";
+
+        while (true)
+        {
+            std::cout << "Your option: ";
+            std::getline(std::cin, input);
+            if (input == "") break;
+            else repeat = std::stoi(input);
+
+            if (repeat < 0 || (repeat == 0 && combined)) std::cout << "Invalid input! Try again.\n";
+            else break;
+        }
+
+        std::cout << std::endl;
+    }
+
+    // Benchmark
+    std::shared_ptr<InstructionTest> instT = CreateTest(mode, type);
+
     instT->threads = threads;
     instT->loop = loop;
+    instT->repeat = repeat;
     instT->type = type;
-    instT->RunTest();
+    instT->denormal_ratio = denormal_ratio;
+
+    if (type == 7)
+    {
+        std::shared_ptr<GemmTest> gemmT = std::dynamic_pointer_cast<GemmTest>(instT);
+        gemmT->tile_vectors = tile_vectors;
+        gemmT->tile_columns = tile_columns;
+        gemmT->unroll = unroll;
+    }
+
+    if (type == 8)
+    {
+        std::shared_ptr<CopyTest> copyT = std::dynamic_pointer_cast<CopyTest>(instT);
+        copyT->max_size = static_cast<size_t>(copy_max_mib) << 20;
+    }
+
+    if (type == 9)
+    {
+        std::shared_ptr<TransitionTest> transitionT = std::dynamic_pointer_cast<TransitionTest>(instT);
+        transitionT->burst_us = burst_us;
+    }
+
+    const int operand_first = operand > 0 ? operand : 1;
+    const int operand_last = operand > 0 ? operand : 5;
+    const int ftz_daz_first = ftz_daz == 2 ? 0 : ftz_daz;
+    const int ftz_daz_last = ftz_daz == 2 ? 1 : ftz_daz;
+    std::vector<double> scores;
+
+    for (int o = operand_first; o <= operand_last; ++o)
+    {
+        for (int f = ftz_daz_first; f <= ftz_daz_last; ++f)
+        {
+            if (combined)
+            {
+                std::cout << "Operand values: " << InstructionTest::OperandName(o)
+                    << ", FTZ/DAZ: " << (f ? "on" : "off") << std::endl;
+            }
+
+            instT->operand = o;
+            instT->ftz_daz = f != 0;
+            instT->RunTest();
+            scores.push_back(instT->MedianScore());
+
+            if (combined) std::cout << std::endl;
+        }
+    }
+
+    // Summary of all the combinations
+    if (combined)
+    {
+        std::cout << "Median result of each combination ("
+            << (type <= 3 ? "GFLOPS, single precision" : "microseconds per loop") << "):\n"
+            << std::fixed << std::setprecision(3);
+
+        for (int o = operand_first, i = 0; o <= operand_last; ++o)
+        {
+            for (int f = ftz_daz_first; f <= ftz_daz_last; ++f, ++i)
+            {
+                std::cout << "    " << std::left << std::setw(10) << InstructionTest::OperandName(o)
+                    << " FTZ/DAZ " << std::setw(4) << (f ? "on" : "off")
+                    << std::right << std::setw(12) << scores[i] << "\n";
+            }
+        }
+
+        std::cout << std::defaultfloat;
+    }
 
     return 0;
 }
@@ -0,0 +1,849 @@
+#pragma once
+
+#include "instruction_test.hpp"
+#include <cmath>
+#include <limits>
+
+// Throughput, latency and accuracy of vectorized math functions
+class MathTest
+    : public InstructionTest
+{
+public:
+    size_t math_length = 0x1000; // elements processed in each loop, L1 resident
+    int chain_length = 0x100000; // iterations of the dependency chain for latency
+    size_t accuracy_samples = 0x100000; // inputs compared against the scalar libm reference
+
+    static const int function_count = 11;
+
+    static const char *FunctionName(int func)
+    {
+        switch (func)
+        {
+        case 1: return "div";
+        case 2: return "rcp";
+        case 3: return "rcp+nr";
+        case 4: return "sqrt";
+        case 5: return "rsqrt";
+        case 6: return "rsqrt+nr";
+        case 7: return "exp";
+        case 8: return "log";
+        case 9: return "sin";
+        case 10: return "cos";
+        case 11: return "tanh";
+        default: return "none";
+        }
+    }
+
+    virtual void RunTest() override
+    {
+        const int threads_new = beginTest();
+        const int loops = loop > 0 ? loop : threads_new;
+        volatile float zero = 0; // unknown to the compiler, keeps the latency chain intact
+
+        times = 0;
+        results.clear();
+        std::vector<double> errors(function_count + 1, -1);
+
+        while (repeat <= 0 || times < repeat)
+        { // infinite loop for continuous tests
+            ++times;
+
+            // dependency overhead of the latency chain
+            const double overhead = latency(0, zero);
+
+            if (!silent)
+            {
+                std::cout << times << ": " << loops << " loops of " << math_length << " elements for each function.\n"
+                    << "    function    throughput (Gop/s)    latency (ns)    max error (ULP)\n";
+            }
+
+            for (int func = 1; func <= function_count; ++func)
+            {
+                const double gops = throughput(func, loops);
+                const double ns = std::max(0.0, latency(func, zero) - overhead);
+                if (errors[func] < 0) errors[func] = maxError(func);
+
+                if (!silent)
+                {
+                    std::cout << "    " << std::left << std::setw(12) << FunctionName(func) << std::right
+                        << std::setprecision(3) << std::setw(18) << gops
+                        << std::setw(16) << ns
+                        << std::setprecision(2) << std::setw(19) << errors[func] << "\n";
+                }
+            }
+        }
+
+        endTest();
+    }
+
+protected:
+    // apply the function to count elements of src
+    virtual void apply(int func, const float *src, float *dst, size_t count) const = 0;
+
+    // iterate x = f(x) * zero + x0 for count times
+    virtual float chain(int func, float x0, float zero, int count) const = 0;
+
+    virtual void kernel() const override {}
+
+    // billions of elements per second over all the threads
+    double throughput(int func, int loops) const
+    {
+        MyClock::time_point t1;
+        MySeconds time_span;
+
+#pragma omp parallel
+        {
+            const unsigned int csr = SetFlushDenormals(ftz_daz);
+            float *src = nullptr;
+            float *dst = nullptr;
+            AlignedMalloc(src, math_length, simdWidth());
+            AlignedMalloc(dst, math_length, simdWidth());
+            fillInputs(func, src, math_length, 1);
+
+#pragma omp single
+            t1 = MyClock::now();
+
+#pragma omp for
+            for (int l = 0; l < loops; ++l)
+            {
+                apply(func, src, dst, math_length);
+            }
+
+#pragma omp single
+            time_span = std::chrono::duration_cast<MySeconds>(MyClock::now() - t1);
+
+            consume(dst, math_length);
+            AlignedFree(src);
+            AlignedFree(dst);
+            _mm_setcsr(csr);
+        }
+
+        return static_cast<double>(math_length) * loops / (time_span.count() * 1e9);
+    }
+
+    // nanoseconds of each iteration in the dependency chain
+    double latency(int func, float zero) const
+    {
+        MyClock::time_point t1 = MyClock::now();
+        const float result = chain(func, 0.75f, zero, chain_length);
+        MySeconds time_span = std::chrono::duration_cast<MySeconds>(MyClock::now() - t1);
+        consume(&result, 1);
+
+        return time_span.count() * 1e9 / chain_length;
+    }
+
+    // maximum error in ULP against the double precision libm result
+    double maxError(int func) const
+    {
+        float *src = nullptr;
+        float *dst = nullptr;
+        AlignedMalloc(src, math_length, simdWidth());
+        AlignedMalloc(dst, math_length, simdWidth());
+        double error = 0;
+
+        for (size_t i = 0; i < accuracy_samples; i += math_length)
+        {
+            fillInputs(func, src, math_length, static_cast<unsigned int>(i / math_length + 2));
+            apply(func, src, dst, math_length);
+
+            for (size_t j = 0; j < math_length; ++j)
+            {
+                error = std::max(error, ulpError(dst[j], reference(func, src[j])));
+            }
+        }
+
+        AlignedFree(src);
+        AlignedFree(dst);
+        return error;
+    }
+
+    static double reference(int func, double x)
+    {
+        switch (func)
+        {
+        case 1:
+        case 2:
+        case 3: return 1 / x;
+        case 4: return std::sqrt(x);
+        case 5:
+        case 6: return 1 / std::sqrt(x);
+        case 7: return std::exp(x);
+        case 8: return std::log(x);
+        case 9: return std::sin(x);
+        case 10: return std::cos(x);
+        case 11: return std::tanh(x);
+        default: return x;
+        }
+    }
+
+    static double ulpError(float y, double ref)
+    {
+        const float ref_float = static_cast<float>(ref);
+        if (std::isnan(ref)) return std::isnan(y) ? 0 : std::numeric_limits<double>::infinity();
+        if (std::isinf(ref_float)) return y == ref_float ? 0 : std::numeric_limits<double>::infinity();
+
+        const float magnitude = std::fabs(ref_float);
+        const double ulp = static_cast<double>(std::nextafter(magnitude, std::numeric_limits<float>::infinity())) - magnitude;
+        return std::fabs(y - ref) / ulp;
+    }
+
+    // random inputs in the domain of each function
+    static void fillInputs(int func, float *dst, size_t count, unsigned int seed)
+    {
+        std::mt19937 gen(seed);
+        double lower = -1;
+        double upper = 1;
+        bool logarithmic = false;
+
+        switch (func)
+        {
+        case 1:
+        case 2:
+        case 3:
+        case 4:
+        case 5:
+        case 6:
+            lower = -60;
+            upper = 60;
+            logarithmic = true;
+            break;
+        case 7:
+            lower = -87;
+            upper = 88;
+            break;
+        case 8:
+            lower = -120;
+            upper = 120;
+            logarithmic = true;
+            break;
+        case 9:
+        case 10:
+            lower = -1000;
+            upper = 1000;
+            break;
+        case 11:
+            lower = -10;
+            upper = 10;
+            break;
+        default:
+            break;
+        }
+
+        std::uniform_real_distribution<double> dist(lower, upper);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const double x = dist(gen);
+            dst[i] = static_cast<float>(logarithmic ? std::exp2(x) : x);
+        }
+    }
+};
+
+
+class AVXMathTest
+    : public MathTest
+{
+public:
+    static const size_t simd_width = 32;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    // AVX has no 256-bit integer instructions, apply the 128-bit one to both halves
+    template < typename _Fn >
+    static __m256i split(const __m256i &a, const __m256i &b, _Fn f)
+    {
+        const __m128i lo = f(_mm256_castsi256_si128(a), _mm256_castsi256_si128(b));
+        const __m128i hi = f(_mm256_extractf128_si256(a, 1), _mm256_extractf128_si256(b, 1));
+        return _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    }
+
+    static __m256 rcp_nr_ps(const __m256 &x)
+    {
+        const __m256 r = _mm256_rcp_ps(x);
+        return _mm256_mul_ps(r, _mm256_sub_ps(_mm256_set1_ps(2), _mm256_mul_ps(x, r)));
+    }
+
+    static __m256 rsqrt_nr_ps(const __m256 &x)
+    {
+        const __m256 r = _mm256_rsqrt_ps(x);
+        const __m256 t = _mm256_sub_ps(_mm256_set1_ps(3), _mm256_mul_ps(_mm256_mul_ps(x, r), r));
+        return _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), r), t);
+    }
+
+    static __m256 exp_ps(__m256 x)
+    {
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-87.3365f)), _mm256_set1_ps(88.0f));
+        const __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(0.693359375f)));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(n, _mm256_set1_ps(-2.12194440e-4f)));
+
+        __m256 p = _mm256_set1_ps(1.9875691500e-4f);
+        p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.3981999507e-3f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(8.3334519073e-3f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(4.1665795894e-2f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.6666665459e-1f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(5.0000001201e-1f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, _mm256_mul_ps(r, r)), _mm256_add_ps(r, _mm256_set1_ps(1)));
+
+        // 2^n
+        const __m256i e = split(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127),
+            [](__m128i a, __m128i b) { return _mm_slli_epi32(_mm_add_epi32(a, b), 23); });
+        return _mm256_mul_ps(p, _mm256_castsi256_ps(e));
+    }
+
+    static __m256 log_ps(__m256 x)
+    {
+        const __m256 invalid = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_NGT_UQ);
+        x = _mm256_max_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x00800000))); // cut off denormals
+        const __m256i i = split(_mm256_castps_si256(x), _mm256_set1_epi32(126),
+            [](__m128i a, __m128i b) { return _mm_sub_epi32(_mm_srli_epi32(a, 23), b); });
+        __m256 e = _mm256_cvtepi32_ps(i);
+
+        // mantissa in [0.5, 1)
+        x = _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(~0x7f800000)));
+        x = _mm256_or_ps(x, _mm256_set1_ps(0.5f));
+
+        // x < sqrt(1/2): e -= 1, x = 2x - 1; otherwise x = x - 1
+        const __m256 mask = _mm256_cmp_ps(x, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+        e = _mm256_sub_ps(e, _mm256_and_ps(_mm256_set1_ps(1), mask));
+        x = _mm256_add_ps(_mm256_sub_ps(x, _mm256_set1_ps(1)), _mm256_and_ps(x, mask));
+
+        const __m256 z = _mm256_mul_ps(x, x);
+        __m256 y = _mm256_set1_ps(7.0376836292e-2f);
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.1514610310e-1f));
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.1676998740e-1f));
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.2420140846e-1f));
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.4249322787e-1f));
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.6668057665e-1f));
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(2.0000714765e-1f));
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-2.4999993993e-1f));
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(3.3333331174e-1f));
+        y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+
+        y = _mm256_add_ps(y, _mm256_mul_ps(e, _mm256_set1_ps(-2.12194440e-4f)));
+        y = _mm256_sub_ps(y, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+        x = _mm256_add_ps(_mm256_add_ps(x, y), _mm256_mul_ps(e, _mm256_set1_ps(0.693359375f)));
+        return _mm256_or_ps(x, invalid); // NaN for x <= 0
+    }
+
+    // Cody-Waite reduction by pi/4 and the minimax polynomials of Cephes
+    static __m256 sincos_ps(__m256 x, bool cosine)
+    {
+        __m256 sign = _mm256_and_ps(x, _mm256_set1_ps(-0.0f));
+        x = _mm256_abs_ps(x);
+
+        // j = (int(x * 4/pi) + 1) & ~1
+        __m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(1.27323954473516f)));
+        j = split(j, _mm256_set1_epi32(1), [](__m128i a, __m128i b) { return _mm_andnot_si128(b, _mm_add_epi32(a, b)); });
+        const __m256 y = _mm256_cvtepi32_ps(j);
+
+        if (cosine)
+        {
+            j = split(j, _mm256_set1_epi32(2), [](__m128i a, __m128i b) { return _mm_sub_epi32(a, b); });
+            sign = _mm256_castsi256_ps(split(j, _mm256_set1_epi32(4),
+                [](__m128i a, __m128i b) { return _mm_slli_epi32(_mm_andnot_si128(a, b), 29); }));
+        }
+        else
+        {
+            sign = _mm256_xor_ps(sign, _mm256_castsi256_ps(split(j, _mm256_set1_epi32(4),
+                [](__m128i a, __m128i b) { return _mm_slli_epi32(_mm_and_si128(a, b), 29); })));
+        }
+        const __m256 poly_mask = _mm256_castsi256_ps(split(j, _mm256_set1_epi32(2),
+            [](__m128i a, __m128i b) { return _mm_cmpeq_epi32(_mm_and_si128(a, b), _mm_setzero_si128()); }));
+
+        x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(0.78515625f)));
+        x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(2.4187564849853515625e-4f)));
+        x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(3.77489497744594108e-8f)));
+        const __m256 z = _mm256_mul_ps(x, x);
+
+        __m256 c = _mm256_set1_ps(2.443315711809948e-5f);
+        c = _mm256_add_ps(_mm256_mul_ps(c, z), _mm256_set1_ps(-1.388731625493765e-3f));
+        c = _mm256_add_ps(_mm256_mul_ps(c, z), _mm256_set1_ps(4.166664568298827e-2f));
+        c = _mm256_mul_ps(_mm256_mul_ps(c, z), z);
+        c = _mm256_add_ps(_mm256_sub_ps(c, _mm256_mul_ps(z, _mm256_set1_ps(0.5f))), _mm256_set1_ps(1));
+
+        __m256 s = _mm256_set1_ps(-1.9515295891e-4f);
+        s = _mm256_add_ps(_mm256_mul_ps(s, z), _mm256_set1_ps(8.3321608736e-3f));
+        s = _mm256_add_ps(_mm256_mul_ps(s, z), _mm256_set1_ps(-1.6666654611e-1f));
+        s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, z), x), x);
+
+        return _mm256_xor_ps(_mm256_blendv_ps(c, s, poly_mask), sign);
+    }
+
+    static __m256 tanh_ps(const __m256 &x)
+    {
+        const __m256 ax = _mm256_abs_ps(x);
+
+        // |x| < 0.625: x + x^3 * P(x^2)
+        const __m256 z = _mm256_mul_ps(x, x);
+        __m256 p = _mm256_set1_ps(-5.70498872745e-3f);
+        p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(2.06390887954e-2f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(-5.37397155531e-2f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(1.33314422036e-1f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(-3.33332819422e-1f));
+        p = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(x, z), p), x);
+
+        // otherwise: 1 - 2 / (exp(2|x|) + 1)
+        const __m256 e = exp_ps(_mm256_add_ps(ax, ax));
+        __m256 q = _mm256_sub_ps(_mm256_set1_ps(1), _mm256_div_ps(_mm256_set1_ps(2), _mm256_add_ps(e, _mm256_set1_ps(1))));
+        q = _mm256_or_ps(q, _mm256_and_ps(x, _mm256_set1_ps(-0.0f)));
+
+        return _mm256_blendv_ps(q, p, _mm256_cmp_ps(ax, _mm256_set1_ps(0.625f), _CMP_LT_OQ));
+    }
+
+    template < typename _Op >
+    static void dispatch(int func, _Op op)
+    {
+        switch (func)
+        {
+        case 1: op([](const __m256 &x) { return _mm256_div_ps(_mm256_set1_ps(1), x); }); break;
+        case 2: op([](const __m256 &x) { return _mm256_rcp_ps(x); }); break;
+        case 3: op([](const __m256 &x) { return rcp_nr_ps(x); }); break;
+        case 4: op([](const __m256 &x) { return _mm256_sqrt_ps(x); }); break;
+        case 5: op([](const __m256 &x) { return _mm256_rsqrt_ps(x); }); break;
+        case 6: op([](const __m256 &x) { return rsqrt_nr_ps(x); }); break;
+        case 7: op([](const __m256 &x) { return exp_ps(x); }); break;
+        case 8: op([](const __m256 &x) { return log_ps(x); }); break;
+        case 9: op([](const __m256 &x) { return sincos_ps(x, false); }); break;
+        case 10: op([](const __m256 &x) { return sincos_ps(x, true); }); break;
+        case 11: op([](const __m256 &x) { return tanh_ps(x); }); break;
+        default: op([](const __m256 &x) { return x; }); break;
+        }
+    }
+
+    virtual void apply(int func, const float *src, float *dst, size_t count) const override
+    {
+        static const size_t simd_step = simd_width / sizeof(float);
+
+        dispatch(func, [&](auto f)
+        {
+            for (size_t i = 0; i < count; i += simd_step)
+            {
+                _mm256_store_ps(dst + i, f(_mm256_load_ps(src + i)));
+            }
+        });
+    }
+
+    virtual float chain(int func, float x0, float zero, int count) const override
+    {
+        float result = 0;
+
+        dispatch(func, [&](auto f)
+        {
+            const __m256 c = _mm256_set1_ps(x0);
+            const __m256 z = _mm256_set1_ps(zero);
+            __m256 x = c;
+
+            for (int i = 0; i < count; ++i)
+            {
+                x = _mm256_add_ps(_mm256_mul_ps(f(x), z), c);
+            }
+
+            result = _mm256_cvtss_f32(x);
+        });
+
+        return result;
+    }
+};
+
+
+class AVX2MathTest
+    : public MathTest
+{
+public:
+    static const size_t simd_width = 32;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    static __m256 rcp_nr_ps(const __m256 &x)
+    {
+        const __m256 r = _mm256_rcp_ps(x);
+        return _mm256_mul_ps(r, _mm256_fnmadd_ps(x, r, _mm256_set1_ps(2)));
+    }
+
+    static __m256 rsqrt_nr_ps(const __m256 &x)
+    {
+        const __m256 r = _mm256_rsqrt_ps(x);
+        const __m256 t = _mm256_fnmadd_ps(_mm256_mul_ps(x, r), r, _mm256_set1_ps(3));
+        return _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), r), t);
+    }
+
+    static __m256 exp_ps(__m256 x)
+    {
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-87.3365f)), _mm256_set1_ps(88.0f));
+        const __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+        r = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), r);
+
+        __m256 p = _mm256_set1_ps(1.9875691500e-4f);
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.3981999507e-3f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(8.3334519073e-3f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(4.1665795894e-2f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.6666665459e-1f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(5.0000001201e-1f));
+        p = _mm256_fmadd_ps(p, _mm256_mul_ps(r, r), _mm256_add_ps(r, _mm256_set1_ps(1)));
+
+        // 2^n
+        const __m256i e = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(p, _mm256_castsi256_ps(e));
+    }
+
+    static __m256 log_ps(__m256 x)
+    {
+        const __m256 invalid = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_NGT_UQ);
+        x = _mm256_max_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x00800000))); // cut off denormals
+        const __m256i i = _mm256_sub_epi32(_mm256_srli_epi32(_mm256_castps_si256(x), 23), _mm256_set1_epi32(126));
+        __m256 e = _mm256_cvtepi32_ps(i);
+
+        // mantissa in [0.5, 1)
+        x = _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(~0x7f800000)));
+        x = _mm256_or_ps(x, _mm256_set1_ps(0.5f));
+
+        // x < sqrt(1/2): e -= 1, x = 2x - 1; otherwise x = x - 1
+        const __m256 mask = _mm256_cmp_ps(x, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+        e = _mm256_sub_ps(e, _mm256_and_ps(_mm256_set1_ps(1), mask));
+        x = _mm256_add_ps(_mm256_sub_ps(x, _mm256_set1_ps(1)), _mm256_and_ps(x, mask));
+
+        const __m256 z = _mm256_mul_ps(x, x);
+        __m256 y = _mm256_set1_ps(7.0376836292e-2f);
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.1514610310e-1f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.1676998740e-1f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.2420140846e-1f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.4249322787e-1f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.6668057665e-1f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(2.0000714765e-1f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-2.4999993993e-1f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(3.3333331174e-1f));
+        y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+
+        y = _mm256_fmadd_ps(e, _mm256_set1_ps(-2.12194440e-4f), y);
+        y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+        x = _mm256_fmadd_ps(e, _mm256_set1_ps(0.693359375f), _mm256_add_ps(x, y));
+        return _mm256_or_ps(x, invalid); // NaN for x <= 0
+    }
+
+    // Cody-Waite reduction by pi/4 and the minimax polynomials of Cephes
+    static __m256 sincos_ps(__m256 x, bool cosine)
+    {
+        __m256 sign = _mm256_and_ps(x, _mm256_set1_ps(-0.0f));
+        x = _mm256_abs_ps(x);
+
+        // j = (int(x * 4/pi) + 1) & ~1
+        __m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(1.27323954473516f)));
+        j = _mm256_andnot_si256(_mm256_set1_epi32(1), _mm256_add_epi32(j, _mm256_set1_epi32(1)));
+        const __m256 y = _mm256_cvtepi32_ps(j);
+
+        if (cosine)
+        {
+            j = _mm256_sub_epi32(j, _mm256_set1_epi32(2));
+            sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(j, _mm256_set1_epi32(4)), 29));
+        }
+        else
+        {
+            sign = _mm256_xor_ps(sign, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29)));
+        }
+        const __m256 poly_mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+
+        x = _mm256_fnmadd_ps(y, _mm256_set1_ps(0.78515625f), x);
+        x = _mm256_fnmadd_ps(y, _mm256_set1_ps(2.4187564849853515625e-4f), x);
+        x = _mm256_fnmadd_ps(y, _mm256_set1_ps(3.77489497744594108e-8f), x);
+        const __m256 z = _mm256_mul_ps(x, x);
+
+        __m256 c = _mm256_set1_ps(2.443315711809948e-5f);
+        c = _mm256_fmadd_ps(c, z, _mm256_set1_ps(-1.388731625493765e-3f));
+        c = _mm256_fmadd_ps(c, z, _mm256_set1_ps(4.166664568298827e-2f));
+        c = _mm256_mul_ps(_mm256_mul_ps(c, z), z);
+        c = _mm256_add_ps(_mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), c), _mm256_set1_ps(1));
+
+        __m256 s = _mm256_set1_ps(-1.9515295891e-4f);
+        s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(8.3321608736e-3f));
+        s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(-1.6666654611e-1f));
+        s = _mm256_fmadd_ps(_mm256_mul_ps(s, z), x, x);
+
+        return _mm256_xor_ps(_mm256_blendv_ps(c, s, poly_mask), sign);
+    }
+
+    static __m256 tanh_ps(const __m256 &x)
+    {
+        const __m256 ax = _mm256_abs_ps(x);
+
+        // |x| < 0.625: x + x^3 * P(x^2)
+        const __m256 z = _mm256_mul_ps(x, x);
+        __m256 p = _mm256_set1_ps(-5.70498872745e-3f);
+        p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(2.06390887954e-2f));
+        p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(-5.37397155531e-2f));
+        p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(1.33314422036e-1f));
+        p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(-3.33332819422e-1f));
+        p = _mm256_fmadd_ps(_mm256_mul_ps(x, z), p, x);
+
+        // otherwise: 1 - 2 / (exp(2|x|) + 1)
+        const __m256 e = exp_ps(_mm256_add_ps(ax, ax));
+        __m256 q = _mm256_sub_ps(_mm256_set1_ps(1), _mm256_div_ps(_mm256_set1_ps(2), _mm256_add_ps(e, _mm256_set1_ps(1))));
+        q = _mm256_or_ps(q, _mm256_and_ps(x, _mm256_set1_ps(-0.0f)));
+
+        return _mm256_blendv_ps(q, p, _mm256_cmp_ps(ax, _mm256_set1_ps(0.625f), _CMP_LT_OQ));
+    }
+
+    template < typename _Op >
+    static void dispatch(int func, _Op op)
+    {
+        switch (func)
+        {
+        case 1: op([](const __m256 &x) { return _mm256_div_ps(_mm256_set1_ps(1), x); }); break;
+        case 2: op([](const __m256 &x) { return _mm256_rcp_ps(x); }); break;
+        case 3: op([](const __m256 &x) { return rcp_nr_ps(x); }); break;
+        case 4: op([](const __m256 &x) { return _mm256_sqrt_ps(x); }); break;
+        case 5: op([](const __m256 &x) { return _mm256_rsqrt_ps(x); }); break;
+        case 6: op([](const __m256 &x) { return rsqrt_nr_ps(x); }); break;
+        case 7: op([](const __m256 &x) { return exp_ps(x); }); break;
+        case 8: op([](const __m256 &x) { return log_ps(x); }); break;
+        case 9: op([](const __m256 &x) { return sincos_ps(x, false); }); break;
+        case 10: op([](const __m256 &x) { return sincos_ps(x, true); }); break;
+        case 11: op([](const __m256 &x) { return tanh_ps(x); }); break;
+        default: op([](const __m256 &x) { return x; }); break;
+        }
+    }
+
+    virtual void apply(int func, const float *src, float *dst, size_t count) const override
+    {
+        static const size_t simd_step = simd_width / sizeof(float);
+
+        dispatch(func, [&](auto f)
+        {
+            for (size_t i = 0; i < count; i += simd_step)
+            {
+                _mm256_store_ps(dst + i, f(_mm256_load_ps(src + i)));
+            }
+        });
+    }
+
+    virtual float chain(int func, float x0, float zero, int count) const override
+    {
+        float result = 0;
+
+        dispatch(func, [&](auto f)
+        {
+            const __m256 c = _mm256_set1_ps(x0);
+            const __m256 z = _mm256_set1_ps(zero);
+            __m256 x = c;
+
+            for (int i = 0; i < count; ++i)
+            {
+                x = _mm256_fmadd_ps(f(x), z, c);
+            }
+
+            result = _mm256_cvtss_f32(x);
+        });
+
+        return result;
+    }
+};
+
+
+class AVX512FMathTest
+    : public MathTest
+{
+public:
+    static const size_t simd_width = 64;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    // bitwise operations on floats are AVX-512DQ, use the integer ones of AVX-512F
+    static __m512 and_ps(const __m512 &a, const __m512 &b)
+    {
+        return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+    }
+
+    static __m512 xor_ps(const __m512 &a, const __m512 &b)
+    {
+        return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+    }
+
+    // rcp14/rsqrt14 are AVX-512F, the 28-bit versions need AVX-512ER
+    static __m512 rcp_nr_ps(const __m512 &x)
+    {
+        const __m512 r = _mm512_rcp14_ps(x);
+        return _mm512_mul_ps(r, _mm512_fnmadd_ps(x, r, _mm512_set1_ps(2)));
+    }
+
+    static __m512 rsqrt_nr_ps(const __m512 &x)
+    {
+        const __m512 r = _mm512_rsqrt14_ps(x);
+        const __m512 t = _mm512_fnmadd_ps(_mm512_mul_ps(x, r), r, _mm512_set1_ps(3));
+        return _mm512_mul_ps(_mm512_mul_ps(_mm512_set1_ps(0.5f), r), t);
+    }
+
+    static __m512 exp_ps(__m512 x)
+    {
+        x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(-87.3365f)), _mm512_set1_ps(88.0f));
+        const __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(1.44269504088896341f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(0.693359375f), x);
+        r = _mm512_fnmadd_ps(n, _mm512_set1_ps(-2.12194440e-4f), r);
+
+        __m512 p = _mm512_set1_ps(1.9875691500e-4f);
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.3981999507e-3f));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(8.3334519073e-3f));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(4.1665795894e-2f));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.6666665459e-1f));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(5.0000001201e-1f));
+        p = _mm512_fmadd_ps(p, _mm512_mul_ps(r, r), _mm512_add_ps(r, _mm512_set1_ps(1)));
+
+        // 2^n
+        const __m512i e = _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23);
+        return _mm512_mul_ps(p, _mm512_castsi512_ps(e));
+    }
+
+    static __m512 log_ps(__m512 x)
+    {
+        const __mmask16 invalid = _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_NGT_UQ);
+        x = _mm512_max_ps(x, _mm512_castsi512_ps(_mm512_set1_epi32(0x00800000))); // cut off denormals
+        const __m512i i = _mm512_sub_epi32(_mm512_srli_epi32(_mm512_castps_si512(x), 23), _mm512_set1_epi32(126));
+        __m512 e = _mm512_cvtepi32_ps(i);
+
+        // mantissa in [0.5, 1)
+        __m512i m = _mm512_and_si512(_mm512_castps_si512(x), _mm512_set1_epi32(~0x7f800000));
+        x = _mm512_castsi512_ps(_mm512_or_si512(m, _mm512_set1_epi32(0x3f000000)));
+
+        // x < sqrt(1/2): e -= 1, x = 2x - 1; otherwise x = x - 1
+        const __mmask16 mask = _mm512_cmp_ps_mask(x, _mm512_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+        e = _mm512_mask_sub_ps(e, mask, e, _mm512_set1_ps(1));
+        const __m512 x1 = _mm512_sub_ps(x, _mm512_set1_ps(1));
+        x = _mm512_mask_add_ps(x1, mask, x1, x);
+
+        const __m512 z = _mm512_mul_ps(x, x);
+        __m512 y = _mm512_set1_ps(7.0376836292e-2f);
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(-1.1514610310e-1f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.1676998740e-1f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(-1.2420140846e-1f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.4249322787e-1f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(-1.6668057665e-1f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(2.0000714765e-1f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(-2.4999993993e-1f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(3.3333331174e-1f));
+        y = _mm512_mul_ps(_mm512_mul_ps(y, x), z);
+
+        y = _mm512_fmadd_ps(e, _mm512_set1_ps(-2.12194440e-4f), y);
+        y = _mm512_fnmadd_ps(z, _mm512_set1_ps(0.5f), y);
+        x = _mm512_fmadd_ps(e, _mm512_set1_ps(0.693359375f), _mm512_add_ps(x, y));
+        return _mm512_mask_blend_ps(invalid, x, _mm512_set1_ps(std::numeric_limits<float>::quiet_NaN())); // NaN for x <= 0
+    }
+
+    // Cody-Waite reduction by pi/4 and the minimax polynomials of Cephes
+    static __m512 sincos_ps(__m512 x, bool cosine)
+    {
+        __m512 sign = and_ps(x, _mm512_set1_ps(-0.0f));
+        x = _mm512_abs_ps(x);
+
+        // j = (int(x * 4/pi) + 1) & ~1
+        __m512i j = _mm512_cvttps_epi32(_mm512_mul_ps(x, _mm512_set1_ps(1.27323954473516f)));
+        j = _mm512_andnot_si512(_mm512_set1_epi32(1), _mm512_add_epi32(j, _mm512_set1_epi32(1)));
+        const __m512 y = _mm512_cvtepi32_ps(j);
+
+        if (cosine)
+        {
+            j = _mm512_sub_epi32(j, _mm512_set1_epi32(2));
+            sign = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_andnot_si512(j, _mm512_set1_epi32(4)), 29));
+        }
+        else
+        {
+            sign = xor_ps(sign, _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_and_si512(j, _mm512_set1_epi32(4)), 29)));
+        }
+        const __mmask16 poly_mask = _mm512_testn_epi32_mask(j, _mm512_set1_epi32(2));
+
+        x = _mm512_fnmadd_ps(y, _mm512_set1_ps(0.78515625f), x);
+        x = _mm512_fnmadd_ps(y, _mm512_set1_ps(2.4187564849853515625e-4f), x);
+        x = _mm512_fnmadd_ps(y, _mm512_set1_ps(3.77489497744594108e-8f), x);
+        const __m512 z = _mm512_mul_ps(x, x);
+
+        __m512 c = _mm512_set1_ps(2.443315711809948e-5f);
+        c = _mm512_fmadd_ps(c, z, _mm512_set1_ps(-1.388731625493765e-3f));
+        c = _mm512_fmadd_ps(c, z, _mm512_set1_ps(4.166664568298827e-2f));
+        c = _mm512_mul_ps(_mm512_mul_ps(c, z), z);
+        c = _mm512_add_ps(_mm512_fnmadd_ps(z, _mm512_set1_ps(0.5f), c), _mm512_set1_ps(1));
+
+        __m512 s = _mm512_set1_ps(-1.9515295891e-4f);
+        s = _mm512_fmadd_ps(s, z, _mm512_set1_ps(8.3321608736e-3f));
+        s = _mm512_fmadd_ps(s, z, _mm512_set1_ps(-1.6666654611e-1f));
+        s = _mm512_fmadd_ps(_mm512_mul_ps(s, z), x, x);
+
+        return xor_ps(_mm512_mask_blend_ps(poly_mask, c, s), sign);
+    }
+
+    static __m512 tanh_ps(const __m512 &x)
+    {
+        const __m512 ax = _mm512_abs_ps(x);
+
+        // |x| < 0.625: x + x^3 * P(x^2)
+        const __m512 z = _mm512_mul_ps(x, x);
+        __m512 p = _mm512_set1_ps(-5.70498872745e-3f);
+        p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(2.06390887954e-2f));
+        p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(-5.37397155531e-2f));
+        p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(1.33314422036e-1f));
+        p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(-3.33332819422e-1f));
+        p = _mm512_fmadd_ps(_mm512_mul_ps(x, z), p, x);
+
+        // otherwise: 1 - 2 / (exp(2|x|) + 1)
+        const __m512 e = exp_ps(_mm512_add_ps(ax, ax));
+        __m512 q = _mm512_sub_ps(_mm512_set1_ps(1), _mm512_div_ps(_mm512_set1_ps(2), _mm512_add_ps(e, _mm512_set1_ps(1))));
+        q = _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(q), _mm512_castps_si512(and_ps(x, _mm512_set1_ps(-0.0f)))));
+
+        return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(ax, _mm512_set1_ps(0.625f), _CMP_LT_OQ), q, p);
+    }
+
+    template < typename _Op >
+    static void dispatch(int func, _Op op)
+    {
+        switch (func)
+        {
+        case 1: op([](const __m512 &x) { return _mm512_div_ps(_mm512_set1_ps(1), x); }); break;
+        case 2: op([](const __m512 &x) { return _mm512_rcp14_ps(x); }); break;
+        case 3: op([](const __m512 &x) { return rcp_nr_ps(x); }); break;
+        case 4: op([](const __m512 &x) { return _mm512_sqrt_ps(x); }); break;
+        case 5: op([](const __m512 &x) { return _mm512_rsqrt14_ps(x); }); break;
+        case 6: op([](const __m512 &x) { return rsqrt_nr_ps(x); }); break;
+        case 7: op([](const __m512 &x) { return exp_ps(x); }); break;
+        case 8: op([](const __m512 &x) { return log_ps(x); }); break;
+        case 9: op([](const __m512 &x) { return sincos_ps(x, false); }); break;
+        case 10: op([](const __m512 &x) { return sincos_ps(x, true); }); break;
+        case 11: op([](const __m512 &x) { return tanh_ps(x); }); break;
+        default: op([](const __m512 &x) { return x; }); break;
+        }
+    }
+
+    virtual void apply(int func, const float *src, float *dst, size_t count) const override
+    {
+        static const size_t simd_step = simd_width / sizeof(float);
+
+        dispatch(func, [&](auto f)
+        {
+            for (size_t i = 0; i < count; i += simd_step)
+            {
+                _mm512_store_ps(dst + i, f(_mm512_load_ps(src + i)));
+            }
+        });
+    }
+
+    virtual float chain(int func, float x0, float zero, int count) const override
+    {
+        float result = 0;
+
+        dispatch(func, [&](auto f)
+        {
+            const __m512 c = _mm512_set1_ps(x0);
+            const __m512 z = _mm512_set1_ps(zero);
+            __m512 x = c;
+
+            for (int i = 0; i < count; ++i)
+            {
+                x = _mm512_fmadd_ps(f(x), z, c);
+            }
+
+            result = _mm512_cvtss_f32(x);
+        });
+
+        return result;
+    }
+};
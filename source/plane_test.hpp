@@ -0,0 +1,560 @@
+#pragma once
+
+#include "instruction_test.hpp"
+
+// Separable FIR passes and transpose over 2D float planes with padded row strides (single thread)
+class PlaneTest
+    : public InstructionTest
+{
+public:
+    std::vector<int> widths = { 512, 1000, 1024, 1920, 2048, 3840, 4096 }; // at plane_height
+    std::vector<int> heights = { 256, 512, 1024, 2160, 4096 }; // at plane_width
+    int plane_width = 2048;
+    int plane_height = 1080;
+    double min_time = 0.05; // seconds of each measurement
+
+    static const int pass_count = 3;
+    static const int policy_count = 3;
+
+    static const char *PassName(int pass)
+    {
+        switch (pass)
+        {
+        case 0: return "horizontal 5-tap FIR";
+        case 1: return "vertical 5-tap FIR (64-byte column strips)";
+        case 2: return "transpose";
+        default: return "none";
+        }
+    }
+
+    static const char *PolicyName(int policy)
+    {
+        switch (policy)
+        {
+        case 0: return "exact";
+        case 1: return "64-B aligned";
+        case 2: return "de-aliased";
+        default: return "none";
+        }
+    }
+
+    // row stride in floats: the row itself, padded to 64 bytes by CalStride,
+    // or padded to an odd number of 64-byte lines so that the rows spread over all the cache sets
+    static size_t Stride(int policy, int width)
+    {
+        switch (policy)
+        {
+        case 1:
+            return CalStride<float>(width, 64) / sizeof(float);
+        case 2:
+        {
+            size_t stride = CalStride<float>(width, 64);
+            if (stride / 64 % 2 == 0) stride += 64;
+            return stride / sizeof(float);
+        }
+        default:
+            return static_cast<size_t>(width);
+        }
+    }
+
+    virtual void RunTest() override
+    {
+        beginTest();
+
+        times = 0;
+        results.clear();
+
+        std::vector<std::pair<int, int>> planes;
+        for (int width : widths) planes.emplace_back(width, plane_height);
+        for (int height : heights)
+        {
+            if (height != plane_height) planes.emplace_back(plane_width, height);
+        }
+
+        while (repeat <= 0 || times < repeat)
+        { // infinite loop for continuous tests
+            ++times;
+
+            for (int pass = 0; pass < pass_count; ++pass)
+            {
+                if (!silent)
+                {
+                    std::cout << times << ": " << PassName(pass) << ", Mpixels/s (single thread)\n"
+                        << "    plane      ";
+                    for (int policy = 0; policy < policy_count; ++policy) std::cout << std::setw(16) << PolicyName(policy);
+                    std::cout << "\n";
+                }
+
+                for (const std::pair<int, int> &plane : planes)
+                {
+                    if (!silent)
+                    {
+                        const std::string name = std::to_string(plane.first) + "x" + std::to_string(plane.second);
+                        std::cout << "    " << std::left << std::setw(11) << name << std::right;
+                    }
+
+                    for (int policy = 0; policy < policy_count; ++policy)
+                    {
+                        const double rate = measure(pass, policy, plane.first, plane.second);
+                        if (!silent) std::cout << std::setprecision(1) << std::setw(16) << rate;
+                    }
+
+                    if (!silent) std::cout << "\n";
+                }
+
+                if (!silent) std::cout << "\n";
+            }
+        }
+
+        endTest();
+    }
+
+protected:
+    static const int taps = 5;
+
+    // binomial low-pass filter
+    static float Tap(int i)
+    {
+        static const float k[taps] = { 1.0f / 16, 4.0f / 16, 6.0f / 16, 4.0f / 16, 1.0f / 16 };
+        return k[i];
+    }
+
+    // dst[y][x] = sum of Tap(i) * src[y][x + i], for x < width - 4
+    virtual void horizontal(const float *src, float *dst, int width, int height, size_t stride) const = 0;
+
+    // dst[y][x] = sum of Tap(i) * src[y + i][x], for y < height - 4
+    virtual void vertical(const float *src, float *dst, int width, int height, size_t stride) const = 0;
+
+    // dst[x][y] = src[y][x]
+    virtual void transpose(const float *src, float *dst, int width, int height, size_t src_stride, size_t dst_stride) const = 0;
+
+    virtual void kernel() const override {}
+
+    static void HorizontalScalar(const float *row, float *out, int first, int last)
+    {
+        for (int x = first; x < last; ++x)
+        {
+            float sum = 0;
+            for (int i = 0; i < taps; ++i) sum += Tap(i) * row[x + i];
+            out[x] = sum;
+        }
+    }
+
+    static void VerticalScalar(const float *src, float *dst, int first, int last, int height, size_t stride)
+    {
+        for (int y = 0; y + taps <= height; ++y)
+        {
+            for (int x = first; x < last; ++x)
+            {
+                float sum = 0;
+                for (int i = 0; i < taps; ++i) sum += Tap(i) * src[(y + i) * stride + x];
+                dst[y * stride + x] = sum;
+            }
+        }
+    }
+
+    // the part of the plane outside of the full blocks
+    static void TransposeScalar(const float *src, float *dst, int width, int height, size_t src_stride, size_t dst_stride, int block)
+    {
+        const int full_width = width / block * block;
+        const int full_height = height / block * block;
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = y < full_height ? full_width : 0; x < width; ++x)
+            {
+                dst[x * dst_stride + y] = src[y * src_stride + x];
+            }
+        }
+    }
+
+    // Mpixels per second of a pass, repeated until min_time is reached
+    double measure(int pass, int policy, int width, int height) const
+    {
+        const size_t src_stride = Stride(policy, width);
+        const size_t dst_stride = pass == 2 ? Stride(policy, height) : src_stride;
+        const size_t src_count = src_stride * height;
+        const size_t dst_count = pass == 2 ? dst_stride * width : src_count;
+
+        float *src = nullptr;
+        float *dst = nullptr;
+        AlignedMalloc(src, src_count, 64);
+        AlignedMalloc(dst, dst_count, 64);
+        for (size_t i = 0; i < src_count; ++i) src[i] = static_cast<float>(i % 251);
+        std::fill(dst, dst + dst_count, 0.0f);
+
+        double rate = 0;
+        for (size_t reps = 1; ; reps *= 2)
+        {
+            MyClock::time_point t1 = MyClock::now();
+            for (size_t r = 0; r < reps; ++r)
+            {
+                switch (pass)
+                {
+                case 0:
+                    horizontal(src, dst, width, height, src_stride);
+                    break;
+                case 1:
+                    vertical(src, dst, width, height, src_stride);
+                    break;
+                default:
+                    transpose(src, dst, width, height, src_stride, dst_stride);
+                    break;
+                }
+            }
+            MySeconds time_span = std::chrono::duration_cast<MySeconds>(MyClock::now() - t1);
+
+            if (time_span.count() >= min_time)
+            {
+                rate = static_cast<double>(width) * height * reps / (time_span.count() * 1e6);
+                break;
+            }
+        }
+
+        consume(dst, dst_count);
+        AlignedFree(src);
+        AlignedFree(dst);
+        return rate;
+    }
+};
+
+
+class AVXPlaneTest
+    : public PlaneTest
+{
+public:
+    static const size_t simd_width = 32;
+
+protected:
+    static const int simd_step = simd_width / sizeof(float);
+
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual void horizontal(const float *src, float *dst, int width, int height, size_t stride) const override
+    {
+        const __m256 k0 = _mm256_set1_ps(Tap(0));
+        const __m256 k1 = _mm256_set1_ps(Tap(1));
+        const __m256 k2 = _mm256_set1_ps(Tap(2));
+        const __m256 k3 = _mm256_set1_ps(Tap(3));
+        const __m256 k4 = _mm256_set1_ps(Tap(4));
+
+        for (int y = 0; y < height; ++y)
+        {
+            const float *row = src + y * stride;
+            float *out = dst + y * stride;
+            int x = 0;
+
+            for (; x + simd_step + taps - 1 <= width; x += simd_step)
+            {
+                __m256 sum = _mm256_mul_ps(k0, _mm256_loadu_ps(row + x));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(k1, _mm256_loadu_ps(row + x + 1)));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(k2, _mm256_loadu_ps(row + x + 2)));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(k3, _mm256_loadu_ps(row + x + 3)));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(k4, _mm256_loadu_ps(row + x + 4)));
+                _mm256_storeu_ps(out + x, sum);
+            }
+
+            HorizontalScalar(row, out, x, width - taps + 1);
+        }
+    }
+
+    virtual void vertical(const float *src, float *dst, int width, int height, size_t stride) const override
+    {
+        const __m256 k0 = _mm256_set1_ps(Tap(0));
+        const __m256 k1 = _mm256_set1_ps(Tap(1));
+        const __m256 k2 = _mm256_set1_ps(Tap(2));
+        const __m256 k3 = _mm256_set1_ps(Tap(3));
+        const __m256 k4 = _mm256_set1_ps(Tap(4));
+        int x = 0;
+
+        // a strip of 2 vectors, keeping the last 5 rows in registers
+        for (; x + 2 * simd_step <= width; x += 2 * simd_step)
+        {
+            const float *col = src + x;
+            float *out = dst + x;
+            __m256 a0 = _mm256_loadu_ps(col), b0 = _mm256_loadu_ps(col + simd_step);
+            __m256 a1 = _mm256_loadu_ps(col + stride), b1 = _mm256_loadu_ps(col + stride + simd_step);
+            __m256 a2 = _mm256_loadu_ps(col + 2 * stride), b2 = _mm256_loadu_ps(col + 2 * stride + simd_step);
+            __m256 a3 = _mm256_loadu_ps(col + 3 * stride), b3 = _mm256_loadu_ps(col + 3 * stride + simd_step);
+
+            for (int y = 0; y + taps <= height; ++y)
+            {
+                const __m256 a4 = _mm256_loadu_ps(col + (y + 4) * stride);
+                const __m256 b4 = _mm256_loadu_ps(col + (y + 4) * stride + simd_step);
+
+                __m256 sa = _mm256_mul_ps(k0, a0);
+                __m256 sb = _mm256_mul_ps(k0, b0);
+                sa = _mm256_add_ps(sa, _mm256_mul_ps(k1, a1));
+                sb = _mm256_add_ps(sb, _mm256_mul_ps(k1, b1));
+                sa = _mm256_add_ps(sa, _mm256_mul_ps(k2, a2));
+                sb = _mm256_add_ps(sb, _mm256_mul_ps(k2, b2));
+                sa = _mm256_add_ps(sa, _mm256_mul_ps(k3, a3));
+                sb = _mm256_add_ps(sb, _mm256_mul_ps(k3, b3));
+                sa = _mm256_add_ps(sa, _mm256_mul_ps(k4, a4));
+                sb = _mm256_add_ps(sb, _mm256_mul_ps(k4, b4));
+                _mm256_storeu_ps(out + y * stride, sa);
+                _mm256_storeu_ps(out + y * stride + simd_step, sb);
+
+                a0 = a1; a1 = a2; a2 = a3; a3 = a4;
+                b0 = b1; b1 = b2; b2 = b3; b3 = b4;
+            }
+        }
+
+        VerticalScalar(src, dst, x, width, height, stride);
+    }
+
+    // 8x8 blocks in registers
+    virtual void transpose(const float *src, float *dst, int width, int height, size_t src_stride, size_t dst_stride) const override
+    {
+        for (int y = 0; y + simd_step <= height; y += simd_step)
+        {
+            for (int x = 0; x + simd_step <= width; x += simd_step)
+            {
+                const float *in = src + y * src_stride + x;
+                float *out = dst + x * dst_stride + y;
+
+                const __m256 r0 = _mm256_loadu_ps(in + 0 * src_stride);
+                const __m256 r1 = _mm256_loadu_ps(in + 1 * src_stride);
+                const __m256 r2 = _mm256_loadu_ps(in + 2 * src_stride);
+                const __m256 r3 = _mm256_loadu_ps(in + 3 * src_stride);
+                const __m256 r4 = _mm256_loadu_ps(in + 4 * src_stride);
+                const __m256 r5 = _mm256_loadu_ps(in + 5 * src_stride);
+                const __m256 r6 = _mm256_loadu_ps(in + 6 * src_stride);
+                const __m256 r7 = _mm256_loadu_ps(in + 7 * src_stride);
+
+                const __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+                const __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+                const __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+                const __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+                const __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+                const __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+                const __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+                const __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+
+                const __m256 s0 = _mm256_shuffle_ps(t0, t2, 0x44);
+                const __m256 s1 = _mm256_shuffle_ps(t0, t2, 0xee);
+                const __m256 s2 = _mm256_shuffle_ps(t1, t3, 0x44);
+                const __m256 s3 = _mm256_shuffle_ps(t1, t3, 0xee);
+                const __m256 s4 = _mm256_shuffle_ps(t4, t6, 0x44);
+                const __m256 s5 = _mm256_shuffle_ps(t4, t6, 0xee);
+                const __m256 s6 = _mm256_shuffle_ps(t5, t7, 0x44);
+                const __m256 s7 = _mm256_shuffle_ps(t5, t7, 0xee);
+
+                _mm256_storeu_ps(out + 0 * dst_stride, _mm256_permute2f128_ps(s0, s4, 0x20));
+                _mm256_storeu_ps(out + 1 * dst_stride, _mm256_permute2f128_ps(s1, s5, 0x20));
+                _mm256_storeu_ps(out + 2 * dst_stride, _mm256_permute2f128_ps(s2, s6, 0x20));
+                _mm256_storeu_ps(out + 3 * dst_stride, _mm256_permute2f128_ps(s3, s7, 0x20));
+                _mm256_storeu_ps(out + 4 * dst_stride, _mm256_permute2f128_ps(s0, s4, 0x31));
+                _mm256_storeu_ps(out + 5 * dst_stride, _mm256_permute2f128_ps(s1, s5, 0x31));
+                _mm256_storeu_ps(out + 6 * dst_stride, _mm256_permute2f128_ps(s2, s6, 0x31));
+                _mm256_storeu_ps(out + 7 * dst_stride, _mm256_permute2f128_ps(s3, s7, 0x31));
+            }
+        }
+
+        TransposeScalar(src, dst, width, height, src_stride, dst_stride, simd_step);
+    }
+};
+
+
+class AVX2PlaneTest
+    : public AVXPlaneTest
+{
+protected:
+    virtual void horizontal(const float *src, float *dst, int width, int height, size_t stride) const override
+    {
+        const __m256 k0 = _mm256_set1_ps(Tap(0));
+        const __m256 k1 = _mm256_set1_ps(Tap(1));
+        const __m256 k2 = _mm256_set1_ps(Tap(2));
+        const __m256 k3 = _mm256_set1_ps(Tap(3));
+        const __m256 k4 = _mm256_set1_ps(Tap(4));
+
+        for (int y = 0; y < height; ++y)
+        {
+            const float *row = src + y * stride;
+            float *out = dst + y * stride;
+            int x = 0;
+
+            for (; x + simd_step + taps - 1 <= width; x += simd_step)
+            {
+                __m256 sum = _mm256_mul_ps(k0, _mm256_loadu_ps(row + x));
+                sum = _mm256_fmadd_ps(k1, _mm256_loadu_ps(row + x + 1), sum);
+                sum = _mm256_fmadd_ps(k2, _mm256_loadu_ps(row + x + 2), sum);
+                sum = _mm256_fmadd_ps(k3, _mm256_loadu_ps(row + x + 3), sum);
+                sum = _mm256_fmadd_ps(k4, _mm256_loadu_ps(row + x + 4), sum);
+                _mm256_storeu_ps(out + x, sum);
+            }
+
+            HorizontalScalar(row, out, x, width - taps + 1);
+        }
+    }
+
+    virtual void vertical(const float *src, float *dst, int width, int height, size_t stride) const override
+    {
+        const __m256 k0 = _mm256_set1_ps(Tap(0));
+        const __m256 k1 = _mm256_set1_ps(Tap(1));
+        const __m256 k2 = _mm256_set1_ps(Tap(2));
+        const __m256 k3 = _mm256_set1_ps(Tap(3));
+        const __m256 k4 = _mm256_set1_ps(Tap(4));
+        int x = 0;
+
+        // a strip of 2 vectors, keeping the last 5 rows in registers
+        for (; x + 2 * simd_step <= width; x += 2 * simd_step)
+        {
+            const float *col = src + x;
+            float *out = dst + x;
+            __m256 a0 = _mm256_loadu_ps(col), b0 = _mm256_loadu_ps(col + simd_step);
+            __m256 a1 = _mm256_loadu_ps(col + stride), b1 = _mm256_loadu_ps(col + stride + simd_step);
+            __m256 a2 = _mm256_loadu_ps(col + 2 * stride), b2 = _mm256_loadu_ps(col + 2 * stride + simd_step);
+            __m256 a3 = _mm256_loadu_ps(col + 3 * stride), b3 = _mm256_loadu_ps(col + 3 * stride + simd_step);
+
+            for (int y = 0; y + taps <= height; ++y)
+            {
+                const __m256 a4 = _mm256_loadu_ps(col + (y + 4) * stride);
+                const __m256 b4 = _mm256_loadu_ps(col + (y + 4) * stride + simd_step);
+
+                __m256 sa = _mm256_mul_ps(k0, a0);
+                __m256 sb = _mm256_mul_ps(k0, b0);
+                sa = _mm256_fmadd_ps(k1, a1, sa);
+                sb = _mm256_fmadd_ps(k1, b1, sb);
+                sa = _mm256_fmadd_ps(k2, a2, sa);
+                sb = _mm256_fmadd_ps(k2, b2, sb);
+                sa = _mm256_fmadd_ps(k3, a3, sa);
+                sb = _mm256_fmadd_ps(k3, b3, sb);
+                sa = _mm256_fmadd_ps(k4, a4, sa);
+                sb = _mm256_fmadd_ps(k4, b4, sb);
+                _mm256_storeu_ps(out + y * stride, sa);
+                _mm256_storeu_ps(out + y * stride + simd_step, sb);
+
+                a0 = a1; a1 = a2; a2 = a3; a3 = a4;
+                b0 = b1; b1 = b2; b2 = b3; b3 = b4;
+            }
+        }
+
+        VerticalScalar(src, dst, x, width, height, stride);
+    }
+};
+
+
+class AVX512FPlaneTest
+    : public PlaneTest
+{
+public:
+    static const size_t simd_width = 64;
+
+protected:
+    static const int simd_step = simd_width / sizeof(float);
+
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual void horizontal(const float *src, float *dst, int width, int height, size_t stride) const override
+    {
+        const __m512 k0 = _mm512_set1_ps(Tap(0));
+        const __m512 k1 = _mm512_set1_ps(Tap(1));
+        const __m512 k2 = _mm512_set1_ps(Tap(2));
+        const __m512 k3 = _mm512_set1_ps(Tap(3));
+        const __m512 k4 = _mm512_set1_ps(Tap(4));
+
+        for (int y = 0; y < height; ++y)
+        {
+            const float *row = src + y * stride;
+            float *out = dst + y * stride;
+            int x = 0;
+
+            for (; x + simd_step + taps - 1 <= width; x += simd_step)
+            {
+                __m512 sum = _mm512_mul_ps(k0, _mm512_loadu_ps(row + x));
+                sum = _mm512_fmadd_ps(k1, _mm512_loadu_ps(row + x + 1), sum);
+                sum = _mm512_fmadd_ps(k2, _mm512_loadu_ps(row + x + 2), sum);
+                sum = _mm512_fmadd_ps(k3, _mm512_loadu_ps(row + x + 3), sum);
+                sum = _mm512_fmadd_ps(k4, _mm512_loadu_ps(row + x + 4), sum);
+                _mm512_storeu_ps(out + x, sum);
+            }
+
+            HorizontalScalar(row, out, x, width - taps + 1);
+        }
+    }
+
+    virtual void vertical(const float *src, float *dst, int width, int height, size_t stride) const override
+    {
+        const __m512 k0 = _mm512_set1_ps(Tap(0));
+        const __m512 k1 = _mm512_set1_ps(Tap(1));
+        const __m512 k2 = _mm512_set1_ps(Tap(2));
+        const __m512 k3 = _mm512_set1_ps(Tap(3));
+        const __m512 k4 = _mm512_set1_ps(Tap(4));
+        int x = 0;
+
+        // a strip of 1 vector, keeping the last 5 rows in registers
+        for (; x + simd_step <= width; x += simd_step)
+        {
+            const float *col = src + x;
+            float *out = dst + x;
+            __m512 a0 = _mm512_loadu_ps(col);
+            __m512 a1 = _mm512_loadu_ps(col + stride);
+            __m512 a2 = _mm512_loadu_ps(col + 2 * stride);
+            __m512 a3 = _mm512_loadu_ps(col + 3 * stride);
+
+            for (int y = 0; y + taps <= height; ++y)
+            {
+                const __m512 a4 = _mm512_loadu_ps(col + (y + 4) * stride);
+
+                __m512 sum = _mm512_mul_ps(k0, a0);
+                sum = _mm512_fmadd_ps(k1, a1, sum);
+                sum = _mm512_fmadd_ps(k2, a2, sum);
+                sum = _mm512_fmadd_ps(k3, a3, sum);
+                sum = _mm512_fmadd_ps(k4, a4, sum);
+                _mm512_storeu_ps(out + y * stride, sum);
+
+                a0 = a1; a1 = a2; a2 = a3; a3 = a4;
+            }
+        }
+
+        VerticalScalar(src, dst, x, width, height, stride);
+    }
+
+    // 16x16 blocks in registers
+    virtual void transpose(const float *src, float *dst, int width, int height, size_t src_stride, size_t dst_stride) const override
+    {
+        for (int y = 0; y + simd_step <= height; y += simd_step)
+        {
+            for (int x = 0; x + simd_step <= width; x += simd_step)
+            {
+                const float *in = src + y * src_stride + x;
+                float *out = dst + x * dst_stride + y;
+                __m512 r[simd_step], t[simd_step];
+
+                for (int i = 0; i < simd_step; ++i) r[i] = _mm512_loadu_ps(in + i * src_stride);
+
+                // 2x2 and 4x4 blocks within the 128-bit lanes
+                for (int i = 0; i < simd_step; i += 2)
+                {
+                    t[i] = _mm512_unpacklo_ps(r[i], r[i + 1]);
+                    t[i + 1] = _mm512_unpackhi_ps(r[i], r[i + 1]);
+                }
+                for (int i = 0; i < simd_step; i += 4)
+                {
+                    r[i] = _mm512_shuffle_ps(t[i], t[i + 2], 0x44);
+                    r[i + 1] = _mm512_shuffle_ps(t[i], t[i + 2], 0xee);
+                    r[i + 2] = _mm512_shuffle_ps(t[i + 1], t[i + 3], 0x44);
+                    r[i + 3] = _mm512_shuffle_ps(t[i + 1], t[i + 3], 0xee);
+                }
+
+                // the 128-bit lanes
+                for (int i = 0; i < 4; ++i)
+                {
+                    t[i] = _mm512_shuffle_f32x4(r[i], r[i + 4], 0x88);
+                    t[i + 4] = _mm512_shuffle_f32x4(r[i], r[i + 4], 0xdd);
+                    t[i + 8] = _mm512_shuffle_f32x4(r[i + 8], r[i + 12], 0x88);
+                    t[i + 12] = _mm512_shuffle_f32x4(r[i + 8], r[i + 12], 0xdd);
+                }
+                for (int i = 0; i < 8; ++i)
+                {
+                    r[i] = _mm512_shuffle_f32x4(t[i], t[i + 8], 0x88);
+                    r[i + 8] = _mm512_shuffle_f32x4(t[i], t[i + 8], 0xdd);
+                }
+
+                for (int i = 0; i < simd_step; ++i) _mm512_storeu_ps(out + i * dst_stride, r[i]);
+            }
+        }
+
+        TransposeScalar(src, dst, width, height, src_stride, dst_stride, simd_step);
+    }
+};
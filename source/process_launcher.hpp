@@ -0,0 +1,304 @@
+#pragma once
+
+#include "instruction_test.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <new>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+// Scaling of type 1-3 over forked processes, each confined to its own CPU set like a container
+class ProcessLauncher
+{
+public:
+    typedef std::function<std::shared_ptr<InstructionTest>(int mode, int type)> Factory;
+
+    int mode = 3;
+    int type = 1;
+    std::vector<int> counts; // numbers of processes to run, powers of 2 up to the CPUs if empty, 1 is always run first
+    int cpus_per_process = 1;
+    int loop = 0; // loops of each process, 0x200 per CPU if 0
+    int repeat = 8;
+    int operand = 1;
+    int denormal_ratio = 50;
+    bool ftz_daz = false;
+    bool use_cgroup = true; // a cgroup v2 cpuset for each process when available, besides the affinity
+
+    explicit ProcessLauncher(const Factory &factory)
+        : factory(factory)
+    {
+    }
+
+#ifdef _WIN32
+    int Run()
+    {
+        std::cout << "The multi-process launcher is not supported on Windows.\n";
+        return 2;
+    }
+#else
+    // the parent never enters an OpenMP parallel region, so the forked children start with a clean runtime
+    int Run()
+    {
+        cpus = AllowedCPUs();
+        const int max_count = static_cast<int>(cpus.size()) / cpus_per_process;
+
+        if (max_count < 1)
+        {
+            std::cout << "1 process of " << cpus_per_process << " CPUs exceeds the " << cpus.size() << " allowed CPUs.\n";
+            return 2;
+        }
+
+        if (counts.empty())
+        {
+            for (int n = 1; n <= max_count; n *= 2) counts.push_back(n);
+            if (counts.back() != max_count) counts.push_back(max_count);
+        }
+
+        // a single process is the reference of the efficiency
+        counts.erase(std::remove(counts.begin(), counts.end(), 1), counts.end());
+        counts.insert(counts.begin(), 1);
+
+        for (int n : counts)
+        {
+            if (n < 1 || n > max_count)
+            {
+                std::cout << n << " processes of " << cpus_per_process << " CPUs exceed the " << cpus.size() << " allowed CPUs.\n";
+                return 2;
+            }
+        }
+
+        std::cout << std::fixed << std::setprecision(3)
+            << "Type " << type << " (mode " << mode << ") in processes of " << cpus_per_process << " CPUs, "
+            << repeat << " repeats in lockstep.\n"
+            << "    processes    per process GFLOPS (min / median / max)    aggregate GFLOPS    efficiency    CPU sets\n";
+
+        double single = 0;
+
+        for (int n : counts)
+        {
+            std::vector<double> scores; // of each process and repeat
+            bool cgroup = false;
+            if (!runProcesses(n, scores, cgroup))
+            {
+                std::cout << "Failed to run " << n << " processes!\n";
+                return 2;
+            }
+
+            std::vector<double> medians, aggregates;
+            for (int p = 0; p < n; ++p)
+            {
+                medians.push_back(Median(std::vector<double>(scores.begin() + p * repeat, scores.begin() + (p + 1) * repeat)));
+            }
+            for (int r = 0; r < repeat; ++r)
+            {
+                double sum = 0;
+                for (int p = 0; p < n; ++p) sum += scores[p * repeat + r];
+                aggregates.push_back(sum);
+            }
+
+            const double aggregate = Median(aggregates);
+            const double median = Median(medians);
+            if (n == 1) single = median;
+
+            std::cout << "    " << std::left << std::setw(13) << n << std::right
+                << std::setw(12) << *std::min_element(medians.begin(), medians.end())
+                << std::setw(12) << median
+                << std::setw(12) << *std::max_element(medians.begin(), medians.end())
+                << std::setw(27) << aggregate
+                << std::setprecision(1) << std::setw(13) << 100 * aggregate / (single * n) << "%"
+                << "    " << (cgroup ? "cgroup v2 cpuset" : "affinity") << "\n" << std::setprecision(3);
+        }
+
+        std::cout << std::defaultfloat;
+        return 0;
+    }
+#endif
+
+private:
+    Factory factory;
+
+#ifndef _WIN32
+    // synchronization of the processes in memory shared over fork(), followed by the GFLOPS of each process and repeat
+    struct alignas(64) Shared
+    {
+        std::atomic<int> arrived;
+        std::atomic<int> generation;
+        std::atomic<int> aborted;
+        std::atomic<int> joined; // processes moved into their cgroups
+    };
+
+    static double *Scores(Shared *shared)
+    {
+        return reinterpret_cast<double *>(shared + 1);
+    }
+
+    std::vector<int> cpus; // allowed CPUs of the parent
+
+    // all the processes wait here until the last one arrives
+    static void Wait(Shared *shared, int parties)
+    {
+        const int generation = shared->generation.load(std::memory_order_acquire);
+        if (shared->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == parties)
+        {
+            shared->arrived.store(0, std::memory_order_relaxed);
+            shared->generation.fetch_add(1, std::memory_order_release);
+            return;
+        }
+
+        while (shared->generation.load(std::memory_order_acquire) == generation)
+        {
+            if (shared->aborted.load(std::memory_order_relaxed)) _exit(3);
+            _mm_pause();
+            sched_yield();
+        }
+    }
+
+    static bool WriteFile(const std::string &path, const std::string &value)
+    {
+        std::ofstream file(path);
+        file << value;
+        file.flush();
+        return static_cast<bool>(file);
+    }
+
+    // the cgroup v2 of this process, if the cpuset controller is delegated to its children
+    static std::string CgroupPath()
+    {
+        std::ifstream self("/proc/self/cgroup");
+        std::string line;
+        while (std::getline(self, line))
+        {
+            if (line.compare(0, 3, "0::") != 0) continue;
+
+            const std::string path = "/sys/fs/cgroup" + line.substr(3);
+            std::ifstream control(path + "/cgroup.subtree_control");
+            std::string controllers;
+            std::getline(control, controllers);
+            if ((" " + controllers + " ").find(" cpuset ") != std::string::npos) return path;
+        }
+        return "";
+    }
+
+    // a child cgroup limited to the CPUs, or an empty path when unavailable
+    std::string createCpuset(int index, const std::vector<int> &set) const
+    {
+        const std::string parent = use_cgroup ? CgroupPath() : "";
+        if (parent.empty()) return "";
+
+        const std::string path = parent + "/mybench-" + std::to_string(getpid()) + "-" + std::to_string(index);
+        if (mkdir(path.c_str(), 0755) != 0) return "";
+
+        std::string list;
+        for (int cpu : set) list += (list.empty() ? "" : ",") + std::to_string(cpu);
+        if (!WriteFile(path + "/cpuset.cpus", list))
+        {
+            rmdir(path.c_str());
+            return "";
+        }
+        return path;
+    }
+
+    // confine the calling process to its CPUs and run the test
+    void runChild(Shared *shared, int index, int n, const std::vector<int> &set, const std::string &cgroup) const
+    {
+        // without the cgroup the affinity still confines the process, and the run is reported as affinity only
+        if (!cgroup.empty() && WriteFile(cgroup + "/cgroup.procs", std::to_string(getpid()))) shared->joined.fetch_add(1);
+
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        for (int cpu : set) CPU_SET(cpu, &mask);
+        if (sched_setaffinity(0, sizeof(mask), &mask) != 0) _exit(2);
+
+        std::shared_ptr<InstructionTest> test = factory(mode, type);
+        test->silent = true;
+        test->threads = cpus_per_process;
+        test->loop = loop > 0 ? loop : 0x200 * cpus_per_process;
+        test->repeat = repeat;
+        test->type = type;
+        test->operand = operand;
+        test->denormal_ratio = denormal_ratio;
+        test->ftz_daz = ftz_daz;
+        test->synchronize = [shared, n]() { Wait(shared, n); };
+        test->RunTest();
+
+        for (int r = 0; r < repeat; ++r)
+        {
+            Scores(shared)[index * repeat + r] = test->Score(test->results[r]);
+        }
+        _exit(0);
+    }
+
+    bool runProcesses(int n, std::vector<double> &scores, bool &cgroup) const
+    {
+        const size_t size = sizeof(Shared) + sizeof(double) * n * repeat;
+        void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) return false;
+
+        Shared *shared = static_cast<Shared *>(memory);
+        new (&shared->arrived) std::atomic<int>(0);
+        new (&shared->generation) std::atomic<int>(0);
+        new (&shared->aborted) std::atomic<int>(0);
+        new (&shared->joined) std::atomic<int>(0);
+
+        std::cout.flush(); // not to be flushed again by the children
+        std::vector<pid_t> children;
+        std::vector<std::string> cgroups;
+        bool success = true;
+
+        for (int i = 0; i < n; ++i)
+        {
+            const std::vector<int> set(cpus.begin() + i * cpus_per_process, cpus.begin() + (i + 1) * cpus_per_process);
+            cgroups.push_back(createCpuset(i, set));
+
+            const pid_t pid = fork();
+            if (pid == 0) runChild(shared, i, n, set, cgroups.back());
+            if (pid < 0)
+            {
+                shared->aborted = 1;
+                success = false;
+                break;
+            }
+            children.push_back(pid);
+        }
+
+        // reap the children in the order they exit, so that an early failure releases the others from the barrier
+        for (size_t reaped = 0; reaped < children.size(); )
+        {
+            int status = 0;
+            const pid_t pid = waitpid(-1, &status, 0);
+            if (pid < 0)
+            {
+                if (errno == EINTR) continue;
+                shared->aborted = 1;
+                success = false;
+                break;
+            }
+            if (std::find(children.begin(), children.end(), pid) == children.end()) continue;
+
+            ++reaped;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                shared->aborted = 1;
+                success = false;
+            }
+        }
+
+        cgroup = shared->joined.load() == n;
+        for (const std::string &path : cgroups)
+        {
+            if (!path.empty()) rmdir(path.c_str());
+        }
+
+        if (success) scores.assign(Scores(shared), Scores(shared) + n * repeat);
+        munmap(memory, size);
+        return success;
+    }
+#endif
+};
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "utils.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+
+// Results of one benchmark run
+struct ResultRecord
+{
+    std::string time;   // UTC time stamp
+    std::string host;   // host fingerprint
+    std::string cpu;    // CPU model
+    std::string system; // OS/kernel/microcode revision, informational only
+    std::string key;    // mode, type and parameters
+    std::vector<double> samples; // elapsed seconds of each repeat
+
+    static ResultRecord Current(const std::string &key, const std::vector<double> &samples)
+    {
+        ResultRecord record;
+        record.time = TimeStamp();
+        record.cpu = CPUModel();
+        record.host = HostFingerprint(record.cpu);
+        record.system = SystemVersion();
+        record.key = key;
+        record.samples = samples;
+        return record;
+    }
+
+    // host name plus a hash of the hardware, so that a re-provisioned node gets a new fingerprint
+    // kernel and microcode versions are excluded, so that updates can be compared on the same host
+    static std::string HostFingerprint(const std::string &cpu)
+    {
+        std::string hardware = cpu;
+#ifdef _OPENMP
+        hardware += "/" + std::to_string(omp_get_num_procs());
+#endif
+        uint32_t hash = 0x811C9DC5; // FNV-1a
+        for (const char c : hardware)
+        {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x01000193;
+        }
+        std::ostringstream ss;
+        ss << HostName() << "-" << std::hex << std::setw(8) << std::setfill('0') << hash;
+        return ss.str();
+    }
+
+    static std::string SystemVersion()
+    {
+#ifdef _WIN32
+        return "windows";
+#else
+        std::string version = "unknown";
+        std::ifstream release("/proc/sys/kernel/osrelease");
+        std::getline(release, version);
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line))
+        {
+            if (line.compare(0, 9, "microcode") == 0)
+            {
+                version += " microcode" + line.substr(line.find(':') + 1);
+                break;
+            }
+        }
+        return version;
+#endif
+    }
+
+    // one line of tab-separated fields, samples are separated by commas
+    std::string Serialize() const
+    {
+        std::ostringstream ss;
+        ss << time << '\t' << host << '\t' << cpu << '\t' << system << '\t' << key << '\t';
+        ss << std::setprecision(9);
+        for (size_t i = 0; i < samples.size(); ++i)
+        {
+            ss << (i ? "," : "") << samples[i];
+        }
+        return ss.str();
+    }
+
+    bool Deserialize(const std::string &line)
+    {
+        std::istringstream ss(line);
+        std::string field;
+        if (!std::getline(ss, time, '\t') || !std::getline(ss, host, '\t') || !std::getline(ss, cpu, '\t')
+            || !std::getline(ss, system, '\t') || !std::getline(ss, key, '\t') || !std::getline(ss, field))
+        {
+            return false;
+        }
+        samples.clear();
+        std::istringstream values(field);
+        std::string value;
+        try
+        {
+            while (std::getline(values, value, ','))
+            {
+                samples.push_back(std::stod(value));
+            }
+        }
+        catch (const std::exception &)
+        { // a malformed line, such as one cut off by an interrupted append
+            samples.clear();
+            return false;
+        }
+        return !samples.empty();
+    }
+};
+
+// Append-only file of benchmark results
+class ResultStore
+{
+public:
+    std::string path;
+
+    explicit ResultStore(const std::string &path)
+        : path(path)
+    {}
+
+    bool Append(const ResultRecord &record) const
+    {
+        std::ofstream file(path, std::ios::app);
+        file << record.Serialize() << '\n';
+        return static_cast<bool>(file);
+    }
+
+    std::vector<ResultRecord> Load() const
+    {
+        std::vector<ResultRecord> records;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            ResultRecord record;
+            if (!line.empty() && line[0] != '#' && record.Deserialize(line)) records.push_back(record);
+        }
+        return records;
+    }
+
+    // the latest record of the same host and parameters
+    bool HostBaseline(const ResultRecord &current, ResultRecord &baseline) const
+    {
+        bool found = false;
+        for (const ResultRecord &record : Load())
+        {
+            if (record.host == current.host && record.key == current.key)
+            {
+                baseline = record;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    // the latest record of every other host with the same CPU model and parameters
+    std::vector<ResultRecord> FleetBaseline(const ResultRecord &current) const
+    {
+        std::map<std::string, ResultRecord> latest;
+        for (const ResultRecord &record : Load())
+        {
+            if (record.host != current.host && record.cpu == current.cpu && record.key == current.key)
+            {
+                latest[record.host] = record;
+            }
+        }
+        std::vector<ResultRecord> records;
+        for (const auto &item : latest) records.push_back(item.second);
+        return records;
+    }
+};
+
+// Two-sided p-value of the Mann-Whitney U test (normal approximation with tie correction)
+// It makes no assumption on the shape of the timing distributions.
+inline double MannWhitneyTest(const std::vector<double> &a, const std::vector<double> &b)
+{
+    const size_t n1 = a.size();
+    const size_t n2 = b.size();
+    const size_t n = n1 + n2;
+    if (n1 == 0 || n2 == 0) return 1;
+
+    std::vector<std::pair<double, int>> values;
+    for (const double v : a) values.emplace_back(v, 0);
+    for (const double v : b) values.emplace_back(v, 1);
+    std::sort(values.begin(), values.end());
+
+    // average ranks of ties
+    double rank_sum = 0;
+    double tie_sum = 0;
+    for (size_t i = 0; i < n;)
+    {
+        size_t j = i;
+        while (j < n && values[j].first == values[i].first) ++j;
+        const double rank = (i + 1 + j) / 2.0;
+        const double t = static_cast<double>(j - i);
+        tie_sum += t * t * t - t;
+        for (size_t k = i; k < j; ++k)
+        {
+            if (values[k].second == 0) rank_sum += rank;
+        }
+        i = j;
+    }
+
+    const double u = rank_sum - n1 * (n1 + 1) / 2.0;
+    const double mu = n1 * n2 / 2.0;
+    const double sigma = std::sqrt(n1 * n2 / 12.0 * ((n + 1) - tie_sum / (n * (n - 1.0))));
+    if (sigma <= 0) return 1;
+    const double z = std::max(0.0, std::abs(u - mu) - 0.5) / sigma;
+    return std::erfc(z / std::sqrt(2.0));
+}
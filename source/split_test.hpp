@@ -0,0 +1,322 @@
+#pragma once
+
+#include "instruction_test.hpp"
+#include <cstring>
+
+// Penalties of unaligned, cache-line-split and page-split loads/stores, and of store forwarding (single thread)
+class SplitTest
+    : public InstructionTest
+{
+public:
+    int iterations = 0x10000; // of the unrolled loop in each measurement
+    int samples = 3; // the fastest one is reported
+    size_t line_size = 64;
+    size_t page_size = 4096;
+
+    static const int access_count = 7;
+
+    static const char *AccessName(int access)
+    {
+        switch (access)
+        {
+        case 0: return "load";
+        case 1: return "store";
+        case 2: return "same size and address";
+        case 3: return "4 B store -> full load";
+        case 4: return "full store -> 4 B load inside";
+        case 5: return "2 half stores -> full load";
+        case 6: return "full store -> load at +4 B";
+        default: return "none";
+        }
+    }
+
+    // 0: aligned to the width, 1: unaligned within a line, 2: split across lines
+    int SplitKind(size_t offset, size_t width) const
+    {
+        if (offset % width == 0) return 0;
+        return offset % line_size + width > line_size ? 2 : 1;
+    }
+
+    virtual void RunTest() override
+    {
+        beginTest();
+
+        // unroll pages for the page splits, and one more for the store forwarding
+        char *arena = nullptr;
+        AlignedMalloc(arena, page_size * (unroll + 2), page_size);
+        std::memset(arena, 1, page_size * (unroll + 2)); // commit the pages
+        char *forward = arena + page_size * (unroll + 1);
+
+        times = 0;
+        results.clear();
+
+        while (repeat <= 0 || times < repeat)
+        { // infinite loop for continuous tests
+            ++times;
+
+            for (size_t width = 16; width <= simdWidth(); width *= 2)
+            {
+                runOffsets(width, arena, forward);
+                runForwarding(width, forward);
+            }
+        }
+
+        AlignedFree(arena);
+        endTest();
+    }
+
+protected:
+    static const int unroll = 8; // independent accesses in each iteration of the throughput loops
+
+    // seconds per access of the vector width, at p and unroll - 1 more addresses of the stride
+    virtual double run(size_t width, int access, char *p, size_t stride) const = 0;
+
+    virtual void kernel() const override {}
+
+    void runOffsets(size_t width, char *arena, char *forward) const
+    {
+        static const int columns = 5;
+        const char *kind_names[] = { "aligned", "unaligned", "line split" };
+        double sums[3][columns] = {};
+        int counts[3] = {};
+        double aligned[columns] = {};
+
+        if (!silent)
+        {
+            std::cout << times << ": " << width * 8 << "-bit loadu/storeu by offset, ns per access (single thread)\n"
+                << "    page columns access the last line of a page, so that the line splits are page splits.\n"
+                << "    offset    access            load     store    page load    page store    store->load\n";
+        }
+
+        for (size_t offset = 0; offset < line_size; ++offset)
+        {
+            char *page = arena + page_size - line_size + offset;
+            const double ns[columns] = {
+                run(width, 0, arena + offset, line_size * 2) * 1e9,
+                run(width, 1, arena + offset, line_size * 2) * 1e9,
+                run(width, 0, page, page_size) * 1e9,
+                run(width, 1, page, page_size) * 1e9,
+                run(width, 2, forward + offset, 0) * 1e9
+            };
+
+            const int kind = SplitKind(offset, width);
+            ++counts[kind];
+            for (int c = 0; c < columns; ++c)
+            {
+                sums[kind][c] += ns[c];
+                if (offset == 0) aligned[c] = ns[c];
+            }
+
+            if (!silent)
+            {
+                std::cout << "    " << std::setw(6) << offset << "    " << std::left << std::setw(12) << kind_names[kind] << std::right
+                    << std::setprecision(2) << std::setw(10) << ns[0] << std::setw(10) << ns[1]
+                    << std::setw(13) << ns[2] << std::setw(14) << ns[3] << std::setw(15) << ns[4] << "\n";
+            }
+        }
+
+        if (!silent)
+        {
+            std::cout << "    Penalty over offset 0 (load, store, page load, page store, store->load):";
+            for (int kind = 1; kind < 3; ++kind)
+            {
+                if (counts[kind] == 0) continue;
+                std::cout << "\n        " << std::left << std::setw(12) << kind_names[kind] << std::right;
+                for (int c = 0; c < columns; ++c)
+                {
+                    std::cout << "    x" << std::left << std::setprecision(2) << std::setw(6) << sums[kind][c] / (counts[kind] * aligned[c]) << std::right;
+                }
+            }
+            std::cout << "\n\n";
+        }
+    }
+
+    void runForwarding(size_t width, char *forward) const
+    {
+        if (!silent)
+        {
+            std::cout << times << ": " << width * 8 << "-bit store forwarding, ns per store->load round trip (single thread)\n"
+                << "    pattern                              ns    penalty\n";
+        }
+
+        double same = 0;
+        for (int access = 2; access < access_count; ++access)
+        {
+            const double ns = run(width, access, forward, 0) * 1e9;
+            if (access == 2) same = ns;
+
+            if (!silent)
+            {
+                std::cout << "    " << std::left << std::setw(30) << AccessName(access) << std::right
+                    << std::setprecision(2) << std::setw(9) << ns << "      x" << ns / same << "\n";
+            }
+        }
+
+        if (!silent) std::cout << "\n";
+    }
+
+    static void Load(__m128 &v, const char *p) { v = _mm_loadu_ps(reinterpret_cast<const float *>(p)); }
+    static void Load(__m256 &v, const char *p) { v = _mm256_loadu_ps(reinterpret_cast<const float *>(p)); }
+    static void Load(__m512 &v, const char *p) { v = _mm512_loadu_ps(p); }
+
+    static void Store(char *p, const __m128 &v) { _mm_storeu_ps(reinterpret_cast<float *>(p), v); }
+    static void Store(char *p, const __m256 &v) { _mm256_storeu_ps(reinterpret_cast<float *>(p), v); }
+    static void Store(char *p, const __m512 &v) { _mm512_storeu_ps(p, v); }
+
+    // the lowest 4 bytes
+    static void LoadLow(__m128 &v, const char *p) { v = _mm_load_ss(reinterpret_cast<const float *>(p)); }
+    static void LoadLow(__m256 &v, const char *p) { v = _mm256_castps128_ps256(_mm_load_ss(reinterpret_cast<const float *>(p))); }
+    static void LoadLow(__m512 &v, const char *p) { v = _mm512_castps128_ps512(_mm_load_ss(reinterpret_cast<const float *>(p))); }
+
+    static void StoreLow(char *p, const __m128 &v) { _mm_store_ss(reinterpret_cast<float *>(p), v); }
+    static void StoreLow(char *p, const __m256 &v) { _mm_store_ss(reinterpret_cast<float *>(p), _mm256_castps256_ps128(v)); }
+    static void StoreLow(char *p, const __m512 &v) { _mm_store_ss(reinterpret_cast<float *>(p), _mm512_castps512_ps128(v)); }
+
+    // the lower half
+    static void StoreHalf(char *p, const __m128 &v) { _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_castps_si128(v)); }
+    static void StoreHalf(char *p, const __m256 &v) { _mm_storeu_ps(reinterpret_cast<float *>(p), _mm256_castps256_ps128(v)); }
+    static void StoreHalf(char *p, const __m512 &v) { _mm256_storeu_ps(reinterpret_cast<float *>(p), _mm512_castps512_ps256(v)); }
+
+    // AVX-512F has no _mm512_xor_ps
+    static __m128 Xor(const __m128 &a, const __m128 &b) { return _mm_xor_ps(a, b); }
+    static __m256 Xor(const __m256 &a, const __m256 &b) { return _mm256_xor_ps(a, b); }
+    static __m512 Xor(const __m512 &a, const __m512 &b) { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_castps_si512(b))); }
+
+    template < typename _Ty >
+    static void LoadXor(_Ty &r, const char *p)
+    {
+        _Ty t;
+        Load(t, p);
+        r = Xor(r, t);
+    }
+
+    template < typename _Ty >
+    FLATTEN double measure(int access, char *p, size_t stride) const
+    {
+        static const size_t width = sizeof(_Ty);
+        const size_t accesses = static_cast<size_t>(iterations) * unroll;
+        char *p0 = p + stride * 0, *p1 = p + stride * 1, *p2 = p + stride * 2, *p3 = p + stride * 3;
+        char *p4 = p + stride * 4, *p5 = p + stride * 5, *p6 = p + stride * 6, *p7 = p + stride * 7;
+
+        _Ty v;
+        Load(v, p);
+        double best = 0;
+
+        for (int s = 0; s < samples; ++s)
+        {
+            MyClock::time_point t1 = MyClock::now();
+
+            switch (access)
+            {
+            case 0: // throughput, the loads are xor-ed into independent chains
+            {
+                // not live across the clock calls, which would keep them in memory
+                _Ty r0 = v, r1 = v, r2 = v, r3 = v, r4 = v, r5 = v, r6 = v, r7 = v;
+                for (int i = 0; i < iterations; ++i)
+                {
+                    LoadXor(r0, p0); LoadXor(r1, p1); LoadXor(r2, p2); LoadXor(r3, p3);
+                    LoadXor(r4, p4); LoadXor(r5, p5); LoadXor(r6, p6); LoadXor(r7, p7);
+                    MEMORY_BARRIER();
+                }
+                v = Xor(Xor(Xor(r0, r1), Xor(r2, r3)), Xor(Xor(r4, r5), Xor(r6, r7)));
+                break;
+            }
+            case 1: // throughput
+                for (int i = 0; i < iterations; ++i)
+                {
+                    Store(p0, v); Store(p1, v); Store(p2, v); Store(p3, v);
+                    Store(p4, v); Store(p5, v); Store(p6, v); Store(p7, v);
+                    MEMORY_BARRIER();
+                }
+                break;
+            case 2: // latency of the round trips through memory from here on
+                for (size_t i = 0; i < accesses; ++i)
+                {
+                    Store(p, v); MEMORY_BARRIER(); Load(v, p);
+                }
+                break;
+            case 3:
+                for (size_t i = 0; i < accesses; ++i)
+                {
+                    StoreLow(p, v); MEMORY_BARRIER(); Load(v, p);
+                }
+                break;
+            case 4:
+                for (size_t i = 0; i < accesses; ++i)
+                {
+                    Store(p, v); MEMORY_BARRIER(); LoadLow(v, p + width / 2);
+                }
+                break;
+            case 5:
+                for (size_t i = 0; i < accesses; ++i)
+                {
+                    StoreHalf(p, v); StoreHalf(p + width / 2, v); MEMORY_BARRIER(); Load(v, p);
+                }
+                break;
+            case 6:
+                for (size_t i = 0; i < accesses; ++i)
+                {
+                    Store(p, v); MEMORY_BARRIER(); Load(v, p + 4);
+                }
+                break;
+            default:
+                break;
+            }
+
+            MySeconds time_span = std::chrono::duration_cast<MySeconds>(MyClock::now() - t1);
+            if (s == 0 || time_span.count() < best) best = time_span.count();
+        }
+
+        float mem[width / sizeof(float)];
+        std::memcpy(mem, &v, sizeof(mem));
+        consume(mem, width / sizeof(float));
+
+        return best / accesses;
+    }
+};
+
+
+class AVXSplitTest
+    : public SplitTest
+{
+public:
+    static const size_t simd_width = 32;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual double run(size_t width, int access, char *p, size_t stride) const override
+    {
+        switch (width)
+        {
+        case 16:
+            return measure<__m128>(access, p, stride);
+        case 32:
+            return measure<__m256>(access, p, stride);
+        default:
+            return 0;
+        }
+    }
+};
+
+
+class AVX512FSplitTest
+    : public AVXSplitTest
+{
+public:
+    static const size_t simd_width = 64;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual double run(size_t width, int access, char *p, size_t stride) const override
+    {
+        switch (width)
+        {
+        case 64:
+            return measure<__m512>(access, p, stride);
+        default:
+            return AVXSplitTest::run(width, access, p, stride);
+        }
+    }
+};
@@ -0,0 +1,493 @@
+#pragma once
+
+#include "instruction_test.hpp"
+#include <atomic>
+
+// Clock transitions caused by a burst of wide vector code, as seen by scalar code on the same core
+class TransitionTest
+    : public InstructionTest
+{
+public:
+    int cpu = -1; // logical CPU to run on, -1 for the current one
+    double burst_us = 200; // length of the vector burst
+    double settle_us = 2000; // scalar probe before the burst, the second half is the baseline
+    double probe_us = 2000; // scalar probe after the burst
+    double sample_us = 1; // scalar work of each sample at the baseline clock
+    double threshold = 0.03; // slowdown regarded as a lower clock
+
+    virtual void RunTest() override
+    {
+        beginTest();
+
+        times = 0;
+        results.clear();
+
+        const double tsc_us = TSCFrequency() / 1e6;
+        const int test_cpu = cpu >= 0 ? cpu : std::max(0, CurrentCPU());
+        const int sibling = SiblingCPU(test_cpu);
+        probe_iterations = calibrateProbe(tsc_us);
+
+        if (!silent)
+        {
+            std::cout << "Burst of " << burstName() << " on CPU " << test_cpu
+                << (sibling >= 0 ? ", scalar probe on its SMT sibling CPU " + std::to_string(sibling) : ", no SMT sibling")
+                << ".\n" << std::setprecision(3)
+                << "    TSC " << tsc_us << " MHz, " << probe_iterations << " scalar iterations per sample.\n\n";
+        }
+
+        std::vector<Sample> self, neighbour, burst;
+        self.reserve(static_cast<size_t>((settle_us + probe_us) / sample_us) * 2 + 0x1000);
+        neighbour.reserve(static_cast<size_t>((settle_us + burst_us + probe_us) / sample_us) * 2 + 0x1000);
+        burst.reserve(static_cast<size_t>(burst_us) * 16 + 0x1000);
+
+        while (repeat <= 0 || times < repeat)
+        { // infinite loop for continuous tests
+            ++times;
+
+            self.clear();
+            neighbour.clear();
+            burst.clear();
+            uint64_t burst_begin = 0;
+            uint64_t burst_end = 0;
+            std::atomic<bool> done(false);
+            std::atomic<bool> pinned(true);
+            std::atomic<bool> restored(true);
+
+#pragma omp parallel num_threads(sibling >= 0 ? 2 : 1)
+            {
+#ifdef _OPENMP
+                const int id = omp_get_thread_num();
+#else
+                const int id = 0;
+#endif
+                const unsigned int csr = SetFlushDenormals(ftz_daz);
+                if (!SetThreadAffinity(id == 0 ? test_cpu : sibling)) pinned = false;
+
+#pragma omp barrier
+
+                if (id == 0)
+                {
+                    const uint64_t settle_end = ReadTSC() + static_cast<uint64_t>(settle_us * tsc_us);
+                    probe(self, [&](uint64_t t) { return t >= settle_end; });
+
+                    burst_begin = ReadTSC();
+                    runBurst(burst, burst_begin + static_cast<uint64_t>(burst_us * tsc_us));
+                    burst_end = ReadTSC();
+
+                    const uint64_t probe_end = burst_end + static_cast<uint64_t>(probe_us * tsc_us);
+                    probe(self, [&](uint64_t t) { return t >= probe_end; });
+                    done = true;
+                }
+                else
+                {
+                    probe(neighbour, [&](uint64_t) { return done.load(std::memory_order_relaxed); });
+                }
+
+                if (!SetThreadAffinity(-1)) restored = false;
+                _mm_setcsr(csr);
+            }
+
+            const uint64_t baseline_begin = burst_begin - static_cast<uint64_t>(settle_us / 2 * tsc_us);
+            const Effect own = analyze(self, baseline_begin, burst_begin, burst_end, tsc_us);
+            const Effect smt = analyze(neighbour, baseline_begin, burst_begin, burst_end, tsc_us);
+
+            if (!silent)
+            {
+                std::cout << std::setprecision(1) << times << ": " << burst_us << " us burst.\n";
+                outputBurst(burst, burst_begin, tsc_us);
+                // unpinned threads may share a core or not, so the sibling numbers would mean nothing
+                if (!pinned) std::cout << "    Failed to pin the threads to their CPUs, the SMT sibling results are skipped.\n";
+                if (!restored) std::cout << "    Failed to restore the thread affinity.\n";
+                outputEffect("Scalar code after the burst", own);
+                if (sibling >= 0 && pinned) outputEffect("Scalar code on the SMT sibling", smt);
+                outputTimeline(own, smt, sibling >= 0 && pinned);
+                std::cout << "\n";
+            }
+        }
+
+        endTest();
+    }
+
+protected:
+    struct Sample
+    {
+        uint64_t end; // TSC at the end of the sample
+        uint64_t ticks; // TSC ticks of the sample
+    };
+
+    // slowdown of a scalar probe relative to its baseline before the burst
+    struct Effect
+    {
+        bool valid = false;
+        double baseline = 0; // median ticks per sample
+        double during = 0; // median slowdown during the burst
+        double dip = 0; // largest drop of throughput (smoothed)
+        double stall_us = 0; // longest sample beyond the baseline
+        double recovery_us = 0; // from the end of the burst until the last slow sample
+        bool recovered = false;
+        std::vector<double> speed; // relative speed in each bin of timelineEdge()
+    };
+
+    int probe_iterations = 1000;
+
+    virtual const char *burstName() const = 0;
+
+    // run the vector code until TSC reaches end, recording a sample for each batch
+    virtual void runBurst(std::vector<Sample> &samples, uint64_t end) const = 0;
+
+    virtual void kernel() const override {}
+
+    static const int burst_batch = 256; // iterations of 8 independent vector operations
+
+    // dependent scalar integer operations, which no compiler folds
+    static uint64_t scalarWork(uint64_t x, int iterations)
+    {
+        for (int i = 0; i < iterations; ++i)
+        {
+            x = x * 0x9E3779B97F4A7C15ull + 1;
+        }
+        return x;
+    }
+
+    // iterations of scalarWork() taking sample_us
+    int calibrateProbe(double tsc_us) const
+    {
+        const int iterations = 0x1000;
+        uint64_t best = ~uint64_t(0);
+        volatile uint64_t sink = 0;
+        for (int i = 0; i < 0x100; ++i)
+        {
+            const uint64_t t = ReadTSC();
+            sink = scalarWork(sink, iterations);
+            best = std::min(best, ReadTSC() - t);
+        }
+        return std::max(1, static_cast<int>(sample_us * tsc_us * iterations / std::max<uint64_t>(best, 1)));
+    }
+
+    template < typename _Stop >
+    void probe(std::vector<Sample> &samples, _Stop stop) const
+    {
+        uint64_t x = 1;
+        uint64_t t = ReadTSC();
+        do
+        {
+            x = scalarWork(x, probe_iterations);
+            const uint64_t now = ReadTSC();
+            samples.push_back({ now, now - t });
+            t = now;
+        } while (!stop(t));
+
+        const int32_t words[2] = { static_cast<int32_t>(x), static_cast<int32_t>(x >> 32) };
+        consume(words, 2);
+    }
+
+    // median of 5 neighbouring samples, to ignore single interrupts
+    static double smoothed(const std::vector<Sample> &samples, size_t i)
+    {
+        const size_t first = i >= 2 ? i - 2 : 0;
+        const size_t last = std::min(samples.size(), i + 3);
+        std::vector<double> values;
+        for (size_t j = first; j < last; ++j) values.push_back(static_cast<double>(samples[j].ticks));
+        return Median(values);
+    }
+
+    static double medianTicks(const std::vector<Sample> &samples, uint64_t begin, uint64_t end)
+    {
+        std::vector<double> values;
+        for (const Sample &s : samples)
+        {
+            if (s.end >= begin && s.end < end) values.push_back(static_cast<double>(s.ticks));
+        }
+        return Median(values);
+    }
+
+    // bins of the timeline after the burst, in microseconds
+    double timelineEdge(int i) const
+    {
+        static const double edges[] = { 1, 2, 5 };
+        double edge = i > 0 ? edges[(i - 1) % 3] : 0;
+        for (int d = (i - 1) / 3; i > 0 && d > 0; --d) edge *= 10;
+        return std::min(edge, probe_us);
+    }
+
+    int timelineBins() const
+    {
+        int bins = 0;
+        while (timelineEdge(bins) < probe_us) ++bins;
+        return bins;
+    }
+
+    Effect analyze(const std::vector<Sample> &samples, uint64_t baseline_begin, uint64_t burst_begin, uint64_t burst_end, double tsc_us) const
+    {
+        Effect effect;
+        effect.baseline = medianTicks(samples, baseline_begin, burst_begin);
+        if (effect.baseline <= 0) return effect;
+        effect.valid = true;
+
+        const double during = medianTicks(samples, burst_begin, burst_end);
+        effect.during = during > 0 ? during / effect.baseline - 1 : 0;
+
+        double slowest = effect.baseline;
+        effect.recovered = true;
+        for (size_t i = 0; i < samples.size(); ++i)
+        {
+            if (samples[i].end < burst_begin) continue;
+
+            const double ticks = smoothed(samples, i);
+            slowest = std::max(slowest, ticks);
+            effect.stall_us = std::max(effect.stall_us, (samples[i].ticks - effect.baseline) / tsc_us);
+
+            if (samples[i].end > burst_end && ticks > effect.baseline * (1 + threshold))
+            {
+                effect.recovery_us = (samples[i].end - burst_end) / tsc_us;
+                effect.recovered = i + 3 < samples.size(); // still slow at the end of the probe
+            }
+        }
+        effect.dip = 1 - effect.baseline / slowest;
+
+        for (int b = 0; b < timelineBins(); ++b)
+        {
+            const uint64_t begin = burst_end + static_cast<uint64_t>(timelineEdge(b) * tsc_us);
+            const uint64_t end = burst_end + static_cast<uint64_t>(timelineEdge(b + 1) * tsc_us);
+            const double ticks = medianTicks(samples, begin, end);
+            effect.speed.push_back(ticks > 0 ? effect.baseline / ticks : 0);
+        }
+
+        return effect;
+    }
+
+    // the burst runs fastest before the clock drops, then settles at the lower clock
+    void outputBurst(const std::vector<Sample> &samples, uint64_t burst_begin, double tsc_us) const
+    {
+        if (samples.size() < 8)
+        {
+            std::cout << "    Burst: too short to analyze.\n";
+            return;
+        }
+
+        size_t fastest = 0;
+        double fast = smoothed(samples, 0);
+        for (size_t i = 1; i < samples.size(); ++i)
+        {
+            const double ticks = smoothed(samples, i);
+            if (ticks < fast)
+            {
+                fast = ticks;
+                fastest = i;
+            }
+        }
+
+        const double steady = medianTicks(samples, samples[samples.size() / 2].end, ~uint64_t(0));
+        const double first = smoothed(samples, 0);
+
+        std::cout << std::setprecision(1)
+            << "    Burst: first batches at " << 100 * fast / first << "% of the fastest throughput";
+
+        if (steady > fast * (1 + threshold))
+        {
+            size_t onset = fastest;
+            while (onset < samples.size() && smoothed(samples, onset) < (fast + steady) / 2) ++onset;
+            std::cout << ", clock drop after " << (samples[onset].end - samples[onset].ticks - burst_begin) / tsc_us
+                << " us, then " << 100 * (1 - fast / steady) << "% lower throughput.\n";
+        }
+        else
+        {
+            std::cout << ", no clock drop within the burst.\n";
+        }
+    }
+
+    void outputEffect(const char *name, const Effect &effect) const
+    {
+        std::cout << "    " << name << ": ";
+        if (!effect.valid)
+        {
+            std::cout << "no samples.\n";
+            return;
+        }
+
+        std::cout << std::setprecision(1);
+        if (effect.during != 0) std::cout << 100 * effect.during << "% slower during the burst, ";
+        std::cout << "throughput dip " << 100 * effect.dip << "%, longest stall " << effect.stall_us << " us, ";
+        if (effect.recovery_us == 0) std::cout << "no slowdown after the burst.\n";
+        else if (effect.recovered) std::cout << "recovered " << effect.recovery_us << " us after the burst.\n";
+        else std::cout << "not recovered within " << probe_us << " us.\n";
+    }
+
+    // percentage, or "-" for a bin without samples
+    static std::string speedName(double speed)
+    {
+        if (speed <= 0) return "-";
+        const int permille = static_cast<int>(speed * 1000 + 0.5);
+        return std::to_string(permille / 10) + "." + std::to_string(permille % 10);
+    }
+
+    void outputTimeline(const Effect &own, const Effect &smt, bool with_sibling) const
+    {
+        if (!own.valid) return;
+
+        std::cout << "    after the burst (us)    scalar speed (%)" << (with_sibling ? "    SMT sibling speed (%)" : "") << "\n";
+        for (int b = 0; b < timelineBins(); ++b)
+        {
+            const std::string range = std::to_string(static_cast<int>(timelineEdge(b))) + " - " + std::to_string(static_cast<int>(timelineEdge(b + 1)));
+            std::cout << "    " << std::left << std::setw(20) << range << std::right << std::setw(20) << speedName(own.speed[b]);
+            if (with_sibling && smt.valid) std::cout << std::setw(25) << speedName(smt.speed[b]);
+            std::cout << "\n";
+        }
+    }
+};
+
+
+class AVXTransitionTest
+    : public TransitionTest
+{
+public:
+    static const size_t simd_width = 32;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual const char *burstName() const override { return "256-bit mul+add (AVX)"; }
+
+    virtual void runBurst(std::vector<Sample> &samples, uint64_t end) const override
+    {
+        volatile float one = 1.0f; // unknown to the compiler
+        const __m256 m = _mm256_set1_ps(one);
+        const __m256 z = _mm256_set1_ps(-0.0f);
+        __m256 r0 = _mm256_set1_ps(1.0f), r1 = _mm256_set1_ps(2.0f), r2 = _mm256_set1_ps(3.0f), r3 = _mm256_set1_ps(4.0f);
+        __m256 r4 = _mm256_set1_ps(5.0f), r5 = _mm256_set1_ps(6.0f), r6 = _mm256_set1_ps(7.0f), r7 = _mm256_set1_ps(8.0f);
+
+        uint64_t t = ReadTSC();
+        do
+        {
+            for (int i = 0; i < burst_batch; ++i)
+            {
+                r0 = _mm256_add_ps(_mm256_mul_ps(r0, m), z);
+                r1 = _mm256_add_ps(_mm256_mul_ps(r1, m), z);
+                r2 = _mm256_add_ps(_mm256_mul_ps(r2, m), z);
+                r3 = _mm256_add_ps(_mm256_mul_ps(r3, m), z);
+                r4 = _mm256_add_ps(_mm256_mul_ps(r4, m), z);
+                r5 = _mm256_add_ps(_mm256_mul_ps(r5, m), z);
+                r6 = _mm256_add_ps(_mm256_mul_ps(r6, m), z);
+                r7 = _mm256_add_ps(_mm256_mul_ps(r7, m), z);
+            }
+            const uint64_t now = ReadTSC();
+            samples.push_back({ now, now - t });
+            t = now;
+        } while (t < end);
+
+        float result[8 * 8];
+        _mm256_storeu_ps(result + 0x00, r0);
+        _mm256_storeu_ps(result + 0x08, r1);
+        _mm256_storeu_ps(result + 0x10, r2);
+        _mm256_storeu_ps(result + 0x18, r3);
+        _mm256_storeu_ps(result + 0x20, r4);
+        _mm256_storeu_ps(result + 0x28, r5);
+        _mm256_storeu_ps(result + 0x30, r6);
+        _mm256_storeu_ps(result + 0x38, r7);
+        consume(result, 8 * 8);
+    }
+};
+
+
+class AVX2TransitionTest
+    : public TransitionTest
+{
+public:
+    static const size_t simd_width = 32;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual const char *burstName() const override { return "256-bit FMA (AVX2+FMA)"; }
+
+    virtual void runBurst(std::vector<Sample> &samples, uint64_t end) const override
+    {
+        volatile float one = 1.0f; // unknown to the compiler
+        const __m256 m = _mm256_set1_ps(one);
+        const __m256 z = _mm256_set1_ps(-0.0f);
+        __m256 r0 = _mm256_set1_ps(1.0f), r1 = _mm256_set1_ps(2.0f), r2 = _mm256_set1_ps(3.0f), r3 = _mm256_set1_ps(4.0f);
+        __m256 r4 = _mm256_set1_ps(5.0f), r5 = _mm256_set1_ps(6.0f), r6 = _mm256_set1_ps(7.0f), r7 = _mm256_set1_ps(8.0f);
+
+        uint64_t t = ReadTSC();
+        do
+        {
+            for (int i = 0; i < burst_batch; ++i)
+            {
+                r0 = _mm256_fmadd_ps(r0, m, z);
+                r1 = _mm256_fmadd_ps(r1, m, z);
+                r2 = _mm256_fmadd_ps(r2, m, z);
+                r3 = _mm256_fmadd_ps(r3, m, z);
+                r4 = _mm256_fmadd_ps(r4, m, z);
+                r5 = _mm256_fmadd_ps(r5, m, z);
+                r6 = _mm256_fmadd_ps(r6, m, z);
+                r7 = _mm256_fmadd_ps(r7, m, z);
+            }
+            const uint64_t now = ReadTSC();
+            samples.push_back({ now, now - t });
+            t = now;
+        } while (t < end);
+
+        float result[8 * 8];
+        _mm256_storeu_ps(result + 0x00, r0);
+        _mm256_storeu_ps(result + 0x08, r1);
+        _mm256_storeu_ps(result + 0x10, r2);
+        _mm256_storeu_ps(result + 0x18, r3);
+        _mm256_storeu_ps(result + 0x20, r4);
+        _mm256_storeu_ps(result + 0x28, r5);
+        _mm256_storeu_ps(result + 0x30, r6);
+        _mm256_storeu_ps(result + 0x38, r7);
+        consume(result, 8 * 8);
+    }
+};
+
+
+class AVX512FTransitionTest
+    : public TransitionTest
+{
+public:
+    static const size_t simd_width = 64;
+
+protected:
+    virtual size_t simdWidth() const override { return simd_width; }
+
+    virtual const char *burstName() const override { return "512-bit FMA (AVX-512F)"; }
+
+    virtual void runBurst(std::vector<Sample> &samples, uint64_t end) const override
+    {
+        volatile float one = 1.0f; // unknown to the compiler
+        const __m512 m = _mm512_set1_ps(one);
+        const __m512 z = _mm512_set1_ps(-0.0f);
+        __m512 r0 = _mm512_set1_ps(1.0f), r1 = _mm512_set1_ps(2.0f), r2 = _mm512_set1_ps(3.0f), r3 = _mm512_set1_ps(4.0f);
+        __m512 r4 = _mm512_set1_ps(5.0f), r5 = _mm512_set1_ps(6.0f), r6 = _mm512_set1_ps(7.0f), r7 = _mm512_set1_ps(8.0f);
+
+        uint64_t t = ReadTSC();
+        do
+        {
+            for (int i = 0; i < burst_batch; ++i)
+            {
+                r0 = _mm512_fmadd_ps(r0, m, z);
+                r1 = _mm512_fmadd_ps(r1, m, z);
+                r2 = _mm512_fmadd_ps(r2, m, z);
+                r3 = _mm512_fmadd_ps(r3, m, z);
+                r4 = _mm512_fmadd_ps(r4, m, z);
+                r5 = _mm512_fmadd_ps(r5, m, z);
+                r6 = _mm512_fmadd_ps(r6, m, z);
+                r7 = _mm512_fmadd_ps(r7, m, z);
+            }
+            const uint64_t now = ReadTSC();
+            samples.push_back({ now, now - t });
+            t = now;
+        } while (t < end);
+
+        float result[16 * 8];
+        _mm512_storeu_ps(result + 0x00, r0);
+        _mm512_storeu_ps(result + 0x10, r1);
+        _mm512_storeu_ps(result + 0x20, r2);
+        _mm512_storeu_ps(result + 0x30, r3);
+        _mm512_storeu_ps(result + 0x40, r4);
+        _mm512_storeu_ps(result + 0x50, r5);
+        _mm512_storeu_ps(result + 0x60, r6);
+        _mm512_storeu_ps(result + 0x70, r7);
+        consume(result, 16 * 8);
+    }
+};
@@ -1,6 +1,36 @@
 #pragma once
 
 #include <chrono>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <thread>
+#include <fstream>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <cstdlib>
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sched.h>
+#endif
+
+// cpuid, rdtsc
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
 
 // Intrinsics
 #if defined(__AVX512__) || defined(__AVX2__) || defined(__AVX__)
@@ -24,6 +54,27 @@
 #include <omp.h>
 #endif
 
+// Inline all the calls in a function, including lambdas (MSVC inlines small lambdas at /O2 anyway)
+#if defined(__GNUC__)
+#define FLATTEN __attribute__((flatten))
+#else
+#define FLATTEN
+#endif
+
+// Hide a vector from the optimizer, so that chains of intrinsics are not folded (MSVC doesn't fold them anyway)
+#if defined(__GNUC__)
+#define OPAQUE(x) __asm__("" : "+v"(x))
+#else
+#define OPAQUE(x) ((void)0)
+#endif
+
+// Keep the loads and stores on either side, so that repeated accesses to the same addresses are neither hoisted nor merged
+#if defined(__GNUC__)
+#define MEMORY_BARRIER() __asm__ __volatile__("" : : : "memory")
+#else
+#define MEMORY_BARRIER() _ReadWriteBarrier()
+#endif
+
 // chrono
 typedef std::chrono::high_resolution_clock MyClock;
 typedef std::chrono::duration<double> MySeconds;
@@ -48,6 +99,42 @@ inline __m128 _mm_abs_ps(const __m128 &x)
 }
 #endif
 
+// Time stamp counter
+
+// TSC ticks, at a constant rate independent of the core clock on modern CPUs (invariant TSC)
+inline uint64_t ReadTSC()
+{
+    return __rdtsc();
+}
+
+// TSC ticks per second, measured against the steady clock
+inline double TSCFrequency(double seconds = 0.02)
+{
+    const MyClock::time_point t1 = MyClock::now();
+    const uint64_t tsc1 = ReadTSC();
+    MySeconds time_span;
+    do
+    {
+        time_span = std::chrono::duration_cast<MySeconds>(MyClock::now() - t1);
+    } while (time_span.count() < seconds);
+    return (ReadTSC() - tsc1) / time_span.count();
+}
+
+// Floating-point environment
+
+// MXCSR bits: flush-to-zero (denormal results) and denormals-are-zero (denormal inputs)
+const unsigned int MXCSR_FTZ = 0x8000;
+const unsigned int MXCSR_DAZ = 0x0040;
+
+// set FTZ/DAZ of the calling thread, and return the previous MXCSR value
+inline unsigned int SetFlushDenormals(bool enable)
+{
+    const unsigned int csr = _mm_getcsr();
+    const unsigned int mask = MXCSR_FTZ | MXCSR_DAZ;
+    _mm_setcsr(enable ? csr | mask : csr & ~mask);
+    return csr;
+}
+
 // Memory allocation
 
 const size_t MEMORY_ALIGNMENT = 64;
@@ -117,3 +204,212 @@ size_t CalStride(int width, size_t Alignment = MEMORY_ALIGNMENT)
     return line_size % Alignment == 0 ? line_size : (line_size / Alignment + 1) * Alignment;
 }
 
+
+// Statistics
+
+inline double Median(std::vector<double> values)
+{
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    const size_t n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+// System information
+
+inline std::string CPUModel()
+{
+    unsigned int regs[12] = {};
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0x80000000);
+    if (static_cast<unsigned int>(info[0]) < 0x80000004) return "unknown";
+    for (int i = 0; i < 3; ++i)
+    {
+        __cpuid(reinterpret_cast<int *>(regs + i * 4), 0x80000002 + i);
+    }
+#else
+    if (__get_cpuid_max(0x80000000, nullptr) < 0x80000004) return "unknown";
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        __get_cpuid(0x80000002 + i, regs + i * 4, regs + i * 4 + 1, regs + i * 4 + 2, regs + i * 4 + 3);
+    }
+#endif
+    std::string model(reinterpret_cast<const char *>(regs), sizeof(regs));
+    model = model.c_str(); // strip the trailing nulls
+    const size_t first = model.find_first_not_of(' ');
+    const size_t last = model.find_last_not_of(' ');
+    return first == std::string::npos ? "unknown" : model.substr(first, last - first + 1);
+}
+
+inline std::string HostName()
+{
+#ifdef _WIN32
+    char *name = nullptr;
+    size_t size = 0;
+    std::string host = "unknown";
+    if (_dupenv_s(&name, &size, "COMPUTERNAME") == 0 && name != nullptr) host = name;
+    free(name);
+    return host;
+#else
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1)) return "unknown";
+    return name;
+#endif
+}
+
+// current UTC time in ISO 8601 format
+inline std::string TimeStamp()
+{
+    const std::time_t now = std::time(nullptr);
+    std::tm utc;
+#ifdef _WIN32
+    gmtime_s(&utc, &now);
+#else
+    gmtime_r(&now, &utc);
+#endif
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return buffer;
+}
+
+// Thread affinity
+
+// logical CPU that the calling thread is running on, or -1
+inline int CurrentCPU()
+{
+#ifdef _WIN32
+    return static_cast<int>(GetCurrentProcessorNumber());
+#else
+    return sched_getcpu();
+#endif
+}
+
+// logical CPUs allowed to the process, such as by taskset or a container cpuset
+inline std::vector<int> AllowedCPUs()
+{
+    std::vector<int> allowed;
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    DWORD_PTR system_mask = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &mask, &system_mask))
+    {
+        for (int i = 0; i < static_cast<int>(sizeof(DWORD_PTR) * 8); ++i)
+        {
+            if (mask & (static_cast<DWORD_PTR>(1) << i)) allowed.push_back(i);
+        }
+    }
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (int i = 0; i < CPU_SETSIZE; ++i)
+        {
+            if (CPU_ISSET(i, &set)) allowed.push_back(i);
+        }
+    }
+#endif
+    if (allowed.empty()) allowed.push_back(0);
+    return allowed;
+}
+
+// pin the calling thread to a logical CPU, or restore the CPUs allowed to the process if cpu < 0
+inline bool SetThreadAffinity(int cpu)
+{
+#ifdef _WIN32
+    const int count = static_cast<int>(std::thread::hardware_concurrency());
+    DWORD_PTR mask = 0;
+    if (cpu < 0)
+    {
+        DWORD_PTR system_mask = 0;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &mask, &system_mask)) return false;
+    }
+    else
+    {
+        if (cpu >= count || cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8)) return false;
+        mask = static_cast<DWORD_PTR>(1) << cpu;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    // taken before any thread is pinned here, so that taskset and cpuset limits are kept
+    static const cpu_set_t allowed = []()
+    {
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        if (sched_getaffinity(0, sizeof(mask), &mask) != 0)
+        {
+            for (int i = 0; i < CPU_SETSIZE; ++i) CPU_SET(i, &mask);
+        }
+        return mask;
+    }();
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpu < 0)
+    {
+        set = allowed;
+    }
+    else
+    {
+        if (cpu >= CPU_SETSIZE) return false;
+        CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#endif
+}
+
+// SMT sibling of a logical CPU, or -1 if the core has a single thread or the topology is unknown
+inline int SiblingCPU(int cpu)
+{
+#ifdef _WIN32
+    // the logical CPUs of each core, in processor group 0 like SetThreadAffinity()
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &length);
+    if (length == 0 || cpu < 0 || cpu >= static_cast<int>(sizeof(KAFFINITY) * 8)) return -1;
+    std::vector<char> buffer(length);
+    if (!GetLogicalProcessorInformationEx(RelationProcessorCore,
+        reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *>(buffer.data()), &length)) return -1;
+
+    for (DWORD offset = 0; offset < length; )
+    {
+        const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info =
+            reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *>(buffer.data() + offset);
+        offset += info->Size;
+
+        const GROUP_AFFINITY &group = info->Processor.GroupMask[0];
+        if (group.Group != 0 || !(group.Mask & (static_cast<KAFFINITY>(1) << cpu))) continue;
+
+        for (int i = 0; i < static_cast<int>(sizeof(KAFFINITY) * 8); ++i)
+        {
+            if (i != cpu && (group.Mask & (static_cast<KAFFINITY>(1) << i))) return i;
+        }
+        return -1;
+    }
+    return -1;
+#else
+    // list such as "0,4" or "0-1"
+    std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list");
+    std::string list;
+    if (file && std::getline(file, list))
+    {
+        size_t pos = 0;
+        while (pos < list.size())
+        {
+            size_t end = list.find(',', pos);
+            if (end == std::string::npos) end = list.size();
+            const std::string item = list.substr(pos, end - pos);
+            const size_t dash = item.find('-');
+            const int first = std::stoi(item);
+            const int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+            for (int i = first; i <= last; ++i)
+            {
+                if (i != cpu) return i;
+            }
+            pos = end + 1;
+        }
+        return -1;
+    }
+    return -1; // no sysfs, guessing would mislabel another core as the sibling
+#endif
+}